@@ -0,0 +1,176 @@
+/*
+ * ImageScalerBenchmark.cpp - micro benchmark for ImageScaler
+ *
+ * Copyright (c) 2017 Tobias Junghans <tobydox@users.sf.net>
+ *
+ * This file is part of Veyon - http://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include <QElapsedTimer>
+#include <QImage>
+
+#include <cstdio>
+#include <functional>
+
+#include "ImageScaler.h"
+
+// compares ImageScaler with QImage::scaled() for common screen resolutions,
+// thumbnail sizes and the dirty block size used by VeyonVncConnection
+
+enum {
+	MinimumBenchmarkTime = 500,		/**< repeat each operation at least that long in ms */
+	ScaledScreenBlockSize = 16
+};
+
+
+static QImage createSourceImage( QSize size )
+{
+	QImage image( size, QImage::Format_RGB32 );
+
+	// noise-like pattern so neither implementation can take shortcuts
+	quint32 value = 0x12345678;
+
+	for( int y = 0; y < image.height(); ++y )
+	{
+		auto line = reinterpret_cast<QRgb *>( image.scanLine( y ) );
+		for( int x = 0; x < image.width(); ++x )
+		{
+			value = value * 1664525 + 1013904223;
+			line[x] = 0xff000000 | ( value >> 8 );
+		}
+	}
+
+	return image;
+}
+
+
+
+// returns average duration of given operation in microseconds
+static double measure( const std::function<void()>& operation )
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	qint64 iterations = 0;
+
+	do
+	{
+		operation();
+		++iterations;
+	} while( timer.elapsed() < MinimumBenchmarkTime );
+
+	return static_cast<double>( timer.nsecsElapsed() ) / iterations / 1000.0;
+}
+
+
+
+static void printResult( const char* name, QSize sourceSize, QSize destinationSize, double qtTime, double scalerTime )
+{
+	printf( "%-10s %5dx%-5d -> %4dx%-4d  QImage::scaled(): %10.1f us  ImageScaler: %10.1f us  speedup: %5.1fx\n",
+			name,
+			sourceSize.width(), sourceSize.height(),
+			destinationSize.width(), destinationSize.height(),
+			qtTime, scalerTime, qtTime / scalerTime );
+}
+
+
+
+static void benchmarkThumbnail( QSize sourceSize, QSize thumbnailSize )
+{
+	const auto source = createSourceImage( sourceSize );
+
+	QImage result;
+
+	const auto qtTime = measure( [&]() {
+		result = source.scaled( thumbnailSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
+	} );
+
+	const auto scalerTime = measure( [&]() {
+		result = ImageScaler::scaled( source, thumbnailSize );
+	} );
+
+	printResult( "thumbnail", sourceSize, thumbnailSize, qtTime, scalerTime );
+}
+
+
+
+static void benchmarkBlock( QSize sourceSize, QSize thumbnailSize )
+{
+	const auto source = createSourceImage( sourceSize );
+
+	QImage destination( thumbnailSize, QImage::Format_RGB32 );
+
+	// rescale a block in the middle of the thumbnail as done for dirty rectangles
+	const QRect block( ( thumbnailSize.width() / 2 ) & ~( ScaledScreenBlockSize - 1 ),
+					   ( thumbnailSize.height() / 2 ) & ~( ScaledScreenBlockSize - 1 ),
+					   ScaledScreenBlockSize, ScaledScreenBlockSize );
+
+	const QRect sourceArea( block.left() * sourceSize.width() / thumbnailSize.width(),
+							block.top() * sourceSize.height() / thumbnailSize.height(),
+							block.width() * sourceSize.width() / thumbnailSize.width(),
+							block.height() * sourceSize.height() / thumbnailSize.height() );
+
+	QImage result;
+
+	const auto qtTime = measure( [&]() {
+		result = source.copy( sourceArea ).scaled( block.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
+	} );
+
+	const auto scalerTime = measure( [&]() {
+		ImageScaler::scale( source, destination, block );
+	} );
+
+	printResult( "block", sourceSize, block.size(), qtTime, scalerTime );
+}
+
+
+
+int main()
+{
+	const QSize sourceSizes[] = {
+		QSize( 1280, 1024 ),
+		QSize( 1920, 1080 ),
+		QSize( 2560, 1440 ),
+		QSize( 3840, 2160 )
+	};
+
+	const QSize thumbnailSizes[] = {
+		QSize( 160, 90 ),
+		QSize( 320, 180 ),
+		QSize( 640, 360 )
+	};
+
+	for( const auto& sourceSize : sourceSizes )
+	{
+		for( const auto& thumbnailSize : thumbnailSizes )
+		{
+			benchmarkThumbnail( sourceSize, thumbnailSize );
+		}
+	}
+
+	for( const auto& sourceSize : sourceSizes )
+	{
+		for( const auto& thumbnailSize : thumbnailSizes )
+		{
+			benchmarkBlock( sourceSize, thumbnailSize );
+		}
+	}
+
+	return 0;
+}
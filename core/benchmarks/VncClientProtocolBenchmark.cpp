@@ -0,0 +1,320 @@
+/*
+ * VncClientProtocolBenchmark.cpp - chunked feed benchmark for VncClientProtocol
+ *
+ * Copyright (c) 2017 Tobias Junghans <tobydox@users.sf.net>
+ *
+ * This file is part of Veyon - http://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QtEndian>
+
+#include <cstdio>
+
+#include "VncClientProtocol.h"
+
+// feeds synthetic framebuffer updates in chunks of typical TCP segment and read
+// buffer sizes to VncClientProtocol and measures the time spent parsing them
+
+enum {
+	SocketTimeout = 5000,
+	FramebufferWidth = 1920,
+	FramebufferHeight = 1080,
+	BytesPerPixel = 4,
+	HextileSubrectCount = 8,
+	Repetitions = 3
+};
+
+
+static bool deliver( QTcpSocket* serverSocket, QTcpSocket* clientSocket, const QByteArray& data )
+{
+	const auto expectedBytes = clientSocket->bytesAvailable() + data.size();
+
+	serverSocket->write( data );
+
+	while( serverSocket->bytesToWrite() > 0 )
+	{
+		if( serverSocket->waitForBytesWritten( SocketTimeout ) == false )
+		{
+			return false;
+		}
+	}
+
+	while( clientSocket->bytesAvailable() < expectedBytes )
+	{
+		if( clientSocket->waitForReadyRead( SocketTimeout ) == false )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+
+static bool receiveReply( QTcpSocket* serverSocket, QTcpSocket* clientSocket, qint64 size )
+{
+	clientSocket->flush();
+
+	while( serverSocket->bytesAvailable() < size )
+	{
+		if( serverSocket->waitForReadyRead( SocketTimeout ) == false )
+		{
+			return false;
+		}
+	}
+
+	return serverSocket->read( size ).size() == size;
+}
+
+
+
+static QByteArray serverInitMessage()
+{
+	const QByteArray name( "benchmark" );
+
+	rfbServerInitMsg message;
+	memset( &message, 0, sizeof(message) );
+
+	message.framebufferWidth = qToBigEndian<uint16_t>( FramebufferWidth );
+	message.framebufferHeight = qToBigEndian<uint16_t>( FramebufferHeight );
+	message.format.bitsPerPixel = BytesPerPixel * 8;
+	message.format.depth = 24;
+	message.format.bigEndian = 0;
+	message.format.trueColour = 1;
+	message.format.redMax = qToBigEndian<uint16_t>( 0xff );
+	message.format.greenMax = qToBigEndian<uint16_t>( 0xff );
+	message.format.blueMax = qToBigEndian<uint16_t>( 0xff );
+	message.format.redShift = 16;
+	message.format.greenShift = 8;
+	message.format.blueShift = 0;
+	message.nameLength = qToBigEndian<uint32_t>( name.size() );
+
+	return QByteArray( reinterpret_cast<const char *>( &message ), sz_rfbServerInitMsg ) + name;
+}
+
+
+
+// acts as VNC server until VncClientProtocol has reached Running state
+static bool performHandshake( QTcpSocket* serverSocket, QTcpSocket* clientSocket, VncClientProtocol& protocol )
+{
+	const char securityTypes[] = { 1, rfbSecTypeVncAuth };
+	const uint32_t authResult = qToBigEndian<uint32_t>( rfbVncAuthOK );
+
+	protocol.start();
+
+	return deliver( serverSocket, clientSocket, QByteArray( "RFB 003.008\n" ) ) &&
+			protocol.read() &&
+			receiveReply( serverSocket, clientSocket, sz_rfbProtocolVersionMsg ) &&
+			deliver( serverSocket, clientSocket, QByteArray( securityTypes, sizeof(securityTypes) ) ) &&
+			protocol.read() &&
+			receiveReply( serverSocket, clientSocket, 1 ) &&
+			deliver( serverSocket, clientSocket, QByteArray( CHALLENGESIZE, '\0' ) ) &&
+			protocol.read() &&
+			receiveReply( serverSocket, clientSocket, CHALLENGESIZE ) &&
+			deliver( serverSocket, clientSocket, QByteArray( reinterpret_cast<const char *>( &authResult ), sizeof(authResult) ) ) &&
+			protocol.read() &&
+			receiveReply( serverSocket, clientSocket, sz_rfbClientInitMsg ) &&
+			deliver( serverSocket, clientSocket, serverInitMessage() ) &&
+			protocol.read() &&
+			protocol.state() == VncClientProtocol::Running;
+}
+
+
+
+static QByteArray updateMessageHeader( uint32_t encoding )
+{
+	rfbFramebufferUpdateMsg header;
+	header.type = rfbFramebufferUpdate;
+	header.pad = 0;
+	header.nRects = qToBigEndian<uint16_t>( 1 );
+
+	rfbFramebufferUpdateRectHeader rectHeader;
+	rectHeader.r.x = 0;
+	rectHeader.r.y = 0;
+	rectHeader.r.w = qToBigEndian<uint16_t>( FramebufferWidth );
+	rectHeader.r.h = qToBigEndian<uint16_t>( FramebufferHeight );
+	rectHeader.encoding = qToBigEndian<uint32_t>( encoding );
+
+	return QByteArray( reinterpret_cast<const char *>( &header ), sz_rfbFramebufferUpdateMsg ) +
+			QByteArray( reinterpret_cast<const char *>( &rectHeader ), sz_rfbFramebufferUpdateRectHeader );
+}
+
+
+
+static QByteArray pixelData( int pixelCount, char seed )
+{
+	QByteArray data( pixelCount * BytesPerPixel, Qt::Uninitialized );
+
+	for( int i = 0; i < data.size(); ++i )
+	{
+		data[i] = static_cast<char>( i * 31 + seed );
+	}
+
+	return data;
+}
+
+
+
+static QByteArray rawUpdate()
+{
+	return updateMessageHeader( rfbEncodingRaw ) + pixelData( FramebufferWidth * FramebufferHeight, 0 );
+}
+
+
+
+// alternates raw tiles and tiles with coloured subrects to exercise all parser states
+static QByteArray hextileUpdate()
+{
+	auto message = updateMessageHeader( rfbEncodingHextile );
+
+	int tileIndex = 0;
+
+	for( int y = 0; y < FramebufferHeight; y += 16 )
+	{
+		for( int x = 0; x < FramebufferWidth; x += 16 )
+		{
+			const int w = qMin( 16, FramebufferWidth - x );
+			const int h = qMin( 16, FramebufferHeight - y );
+
+			if( tileIndex++ % 2 == 0 )
+			{
+				message.append( static_cast<char>( rfbHextileRaw ) );
+				message.append( pixelData( w * h, static_cast<char>( tileIndex ) ) );
+			}
+			else
+			{
+				message.append( static_cast<char>( rfbHextileBackgroundSpecified |
+												   rfbHextileAnySubrects |
+												   rfbHextileSubrectsColoured ) );
+				message.append( pixelData( 1, 0 ) );
+				message.append( static_cast<char>( HextileSubrectCount ) );
+
+				for( int i = 0; i < HextileSubrectCount; ++i )
+				{
+					message.append( pixelData( 1, static_cast<char>( i ) ) );
+					message.append( static_cast<char>( ( i << 4 ) | i ) );	// x/y
+					message.append( static_cast<char>( 0x11 ) );			// (w-1)/(h-1)
+				}
+			}
+		}
+	}
+
+	return message;
+}
+
+
+
+static bool benchmarkUpdate( const char* name, const QByteArray& update, int chunkSize,
+							 QTcpSocket* serverSocket, QTcpSocket* clientSocket, VncClientProtocol& protocol )
+{
+	QElapsedTimer timer;
+	qint64 parseTime = 0;
+	int messageCount = 0;
+
+	for( int repetition = 0; repetition < Repetitions; ++repetition )
+	{
+		for( int pos = 0; pos < update.size(); pos += chunkSize )
+		{
+			if( deliver( serverSocket, clientSocket, update.mid( pos, chunkSize ) ) == false )
+			{
+				fprintf( stderr, "could not deliver update data\n" );
+				return false;
+			}
+
+			timer.start();
+
+			while( protocol.receiveMessage() )
+			{
+				++messageCount;
+			}
+
+			parseTime += timer.nsecsElapsed();
+		}
+	}
+
+	if( messageCount != Repetitions )
+	{
+		fprintf( stderr, "%s: parsed %d instead of %d messages\n", name, messageCount, Repetitions );
+		return false;
+	}
+
+	const double totalBytes = static_cast<double>( update.size() ) * Repetitions;
+
+	printf( "%-8s %8.1f KiB/update  chunk size: %6d  %8.2f ms/update  %8.1f MiB/s\n",
+			name, update.size() / 1024.0, chunkSize,
+			parseTime / 1000000.0 / Repetitions,
+			totalBytes / 1024 / 1024 / ( parseTime / 1000000000.0 ) );
+
+	return true;
+}
+
+
+
+int main( int argc, char** argv )
+{
+	QCoreApplication app( argc, argv );
+
+	QTcpServer server;
+	if( server.listen( QHostAddress::LocalHost ) == false )
+	{
+		fprintf( stderr, "could not listen on localhost\n" );
+		return 1;
+	}
+
+	QTcpSocket clientSocket;
+	clientSocket.connectToHost( QHostAddress::LocalHost, server.serverPort() );
+
+	if( clientSocket.waitForConnected( SocketTimeout ) == false ||
+			server.waitForNewConnection( SocketTimeout ) == false )
+	{
+		fprintf( stderr, "could not establish loopback connection\n" );
+		return 1;
+	}
+
+	auto serverSocket = server.nextPendingConnection();
+
+	VncClientProtocol protocol( &clientSocket, QStringLiteral( "benchmark" ) );
+
+	if( performHandshake( serverSocket, &clientSocket, protocol ) == false )
+	{
+		fprintf( stderr, "RFB handshake failed\n" );
+		return 1;
+	}
+
+	const int chunkSizes[] = { 1460, 16384, 65536 };
+
+	const auto raw = rawUpdate();
+	const auto hextile = hextileUpdate();
+
+	for( auto chunkSize : chunkSizes )
+	{
+		if( benchmarkUpdate( "raw", raw, chunkSize, serverSocket, &clientSocket, protocol ) == false ||
+				benchmarkUpdate( "hextile", hextile, chunkSize, serverSocket, &clientSocket, protocol ) == false )
+		{
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -46,6 +46,8 @@ public:
 
 	AccessResult checkAccess( const QString& accessingUser, const QString& accessingComputer,
 							  const QStringList& connectedUsers );
+	AccessResult checkAccess( const QString& accessingUser, const QString& accessingComputer,
+							  const QString& localUser, const QStringList& connectedUsers );
 
 	bool processAuthorizedGroups( const QString& accessingUser );
 
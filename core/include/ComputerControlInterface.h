@@ -27,9 +27,11 @@
 
 #include <QList>
 #include <QObject>
+#include <QSharedPointer>
 #include <QSize>
 
 #include "Feature.h"
+#include "HostReachabilityProber.h"
 #include "VeyonCore.h"
 
 class QImage;
@@ -39,6 +41,7 @@ class Computer;
 class FeatureMessage;
 class VeyonVncConnection;
 class VeyonCoreConnection;
+class VncConnectionPool;
 
 class VEYON_CORE_EXPORT ComputerControlInterface : public QObject
 {
@@ -56,10 +59,18 @@ public:
 		StateCount
 	} State;
 
+	typedef enum UpdateModes
+	{
+		FullUpdates,		/**< computer screen is visible */
+		ReducedUpdates,		/**< computer screen is scrolled out of view */
+		SuspendedUpdates	/**< monitoring view is hidden or minimized */
+	} UpdateMode;
+
 	ComputerControlInterface( const Computer& computer, QObject* parent = nullptr );
 	~ComputerControlInterface() override;
 
-	void start( QSize scaledScreenSize, BuiltinFeatures* builtinFeatures );
+	void start( QSize scaledScreenSize, BuiltinFeatures* builtinFeatures, VncConnectionPool* connectionPool = nullptr,
+				const QSharedPointer<HostReachabilityProber>& reachabilityProber = QSharedPointer<HostReachabilityProber>() );
 	void stop();
 
 	const Computer& computer() const
@@ -79,6 +90,13 @@ public:
 
 	void setScaledScreenSize( QSize size );
 
+	UpdateMode updateMode() const
+	{
+		return m_updateMode;
+	}
+
+	void setUpdateMode( UpdateMode updateMode );
+
 	QImage scaledScreen() const;
 
 	QImage screen() const;
@@ -100,6 +118,11 @@ public:
 
 	void setUser( const QString& user );
 
+	void setUserUpdatesPushed( bool pushed )
+	{
+		m_userUpdatesPushed = pushed;
+	}
+
 	const FeatureUidList& activeFeatures() const
 	{
 		return m_activeFeatures;
@@ -107,6 +130,11 @@ public:
 
 	void setActiveFeatures( const FeatureUidList& activeFeatures );
 
+	void setActiveFeatureUpdatesPushed( bool pushed )
+	{
+		m_activeFeatureUpdatesPushed = pushed;
+	}
+
 	Feature::Uid designatedModeFeature() const
 	{
 		return m_designatedModeFeature;
@@ -116,6 +144,8 @@ public:
 
 	void sendFeatureMessage( const FeatureMessage& featureMessage );
 
+	void retryConnectionNow();
+
 
 private slots:
 	void setScreenUpdateFlag()
@@ -126,22 +156,32 @@ private slots:
 	void updateState();
 	void updateUser();
 	void updateActiveFeatures();
+	void subscribeServiceState();
+	void pollServiceState();
+	void handleReachabilityChange( const QString& host, int port, HostReachabilityProber::Reachability reachability );
 
 	void handleFeatureMessage( const FeatureMessage& message );
 
 private:
 	enum {
 		FramebufferUpdateInterval = 1000,
+		ReducedFramebufferUpdateInterval = 10000,
+		SuspendedFramebufferUpdateInterval = 60000
 	};
 
+	int framebufferUpdateInterval() const;
+
 	const Computer& m_computer;
 
 	State m_state;
 	QString m_user;
 	FeatureUidList m_activeFeatures;
 	Feature::Uid m_designatedModeFeature;
+	bool m_userUpdatesPushed;
+	bool m_activeFeatureUpdatesPushed;
 
 	QSize m_scaledScreenSize;
+	UpdateMode m_updateMode;
 
 	VeyonVncConnection* m_vncConnection;
 	VeyonCoreConnection* m_coreConnection;
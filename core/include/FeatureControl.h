@@ -25,6 +25,8 @@
 #ifndef FEATURE_CONTROL_H
 #define FEATURE_CONTROL_H
 
+#include <QPointer>
+
 #include "FeaturePluginInterface.h"
 
 class VEYON_CORE_EXPORT FeatureControl : public QObject, public FeaturePluginInterface, public PluginInterface
@@ -36,6 +38,7 @@ public:
 	~FeatureControl() override;
 
 	bool queryActiveFeatures( const ComputerControlInterfaceList& computerControlInterfaces );
+	bool subscribeActiveFeatures( const ComputerControlInterfaceList& computerControlInterfaces );
 
 	Plugin::Uid uid() const override
 	{
@@ -94,18 +97,29 @@ private:
 	enum Commands
 	{
 		QueryActiveFeatures,
+		SubscribeActiveFeatures,
 	};
 
 	enum Arguments
 	{
 		ActiveFeatureList,
+		SubscriptionActive,
 	};
 
+	void addSubscriber( QIODevice* ioDevice, FeatureWorkerManager& featureWorkerManager );
+	void schedulePushActiveFeatures();
+	void pushActiveFeatures();
+	void sendActiveFeatures( QIODevice* ioDevice, FeatureMessage::Command command, const FeatureUidList& activeFeatures );
+
 	Feature m_featureControlFeature;
 	FeatureList m_features;
 
 	FeatureUidList m_activeFeatures;
 
+	QPointer<FeatureWorkerManager> m_featureWorkerManager;
+	QList<QPointer<QIODevice> > m_subscribers;
+	bool m_pushPending;
+
 };
 
 #endif // FEATURE_CONTROL_H
@@ -52,6 +52,9 @@ public:
 	bool isWorkerRunning( const Feature& feature );
 	FeatureUidList runningWorkers();
 
+signals:
+	void runningWorkersChanged();
+
 private slots:
 	void acceptConnection();
 	void processConnection( QTcpSocket* socket );
@@ -0,0 +1,144 @@
+/*
+ * HostReachabilityProber.h - declaration of HostReachabilityProber class
+ *
+ * Copyright (c) 2017 Tobias Junghans <tobydox@users.sf.net>
+ *
+ * This file is part of Veyon - http://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef HOST_REACHABILITY_PROBER_H
+#define HOST_REACHABILITY_PROBER_H
+
+#include <QAbstractSocket>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QThread>
+#include <QTimer>
+#include <QWaitCondition>
+
+#include "VeyonCore.h"
+
+class QTcpSocket;
+class HostReachabilityProberWorker;
+
+// determines reachability of many hosts at once by running batched sweeps of
+// non-blocking TCP connection attempts in a separate thread and caches the results
+class VEYON_CORE_EXPORT HostReachabilityProber : public QObject
+{
+	Q_OBJECT
+public:
+	typedef enum Reachabilities
+	{
+		Unknown,
+		HostOffline,
+		ServiceUnreachable,
+		ServiceReachable
+	} Reachability;
+
+	Q_ENUM(Reachability)
+
+	explicit HostReachabilityProber( QObject* parent = nullptr );
+	~HostReachabilityProber() override;
+
+	// returns cached result without probing
+	Reachability reachability( const QString& host, int port ) const;
+
+	// returns cached result if still valid or waits for the result of the next sweep otherwise
+	Reachability probe( const QString& host, int port );
+
+	// discard cached results for given host, e.g. after sending a Wake-on-LAN packet
+	void invalidate( const QString& host );
+
+signals:
+	void reachabilityChanged( const QString& host, int port, HostReachabilityProber::Reachability reachability );
+	void sweepRequested();
+
+private:
+	enum {
+		ProbeTimeout = 1000,
+		ResultLifetime = 3000,
+		SweepCoalesceDelay = 20,	/**< collect probe requests that long before starting a sweep */
+		SweepInterval = 5000,		/**< re-probe hosts which are not reachable regularly to notice changes */
+		WatchTimeout = 30000,		/**< forget hosts which have not been queried for that long */
+		ProbeWaitTimeout = SweepCoalesceDelay + ProbeTimeout*2
+	};
+
+	typedef QPair<QString, int> Target;
+
+	struct Result
+	{
+		Result() :
+			reachability( Unknown ),
+			probeCount( 0 ),
+			probePending( false ),
+			probeTimer(),
+			queryTimer()
+		{
+		}
+
+		Reachability reachability;
+		int probeCount;
+		bool probePending;
+		QElapsedTimer probeTimer;
+		QElapsedTimer queryTimer;
+	} ;
+
+	QList<Target> takeSweepTargets();
+	int nextSweepDelay() const;
+	void storeResult( const Target& target, Reachability reachability );
+
+	QThread m_thread;
+	HostReachabilityProberWorker* m_worker;
+
+	mutable QMutex m_resultsLock;
+	QWaitCondition m_resultsAvailable;
+	QHash<Target, Result> m_results;
+	bool m_shutdown;
+
+	friend class HostReachabilityProberWorker;
+
+} ;
+
+
+
+class HostReachabilityProberWorker : public QObject
+{
+	Q_OBJECT
+public:
+	explicit HostReachabilityProberWorker( HostReachabilityProber* prober );
+
+	void scheduleSweep();
+
+private:
+	void sweep();
+	void finishProbe( QTcpSocket* socket, HostReachabilityProber::Reachability reachability );
+	void handleError( QTcpSocket* socket, QAbstractSocket::SocketError error );
+	void abortProbes();
+	void finishSweep();
+
+	HostReachabilityProber* m_prober;
+	QTimer m_sweepTimer;
+	QTimer m_timeoutTimer;
+	QHash<QTcpSocket *, HostReachabilityProber::Target> m_probes;
+
+} ;
+
+#endif
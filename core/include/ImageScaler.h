@@ -0,0 +1,48 @@
+/*
+ * ImageScaler.h - declaration of ImageScaler class
+ *
+ * Copyright (c) 2017 Tobias Junghans <tobydox@users.sf.net>
+ *
+ * This file is part of Veyon - http://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef IMAGE_SCALER_H
+#define IMAGE_SCALER_H
+
+#include <QImage>
+
+#include "VeyonCore.h"
+
+// area-averaging (box filter) downscaler for RGB32 images with SSE2/AVX2 kernels
+// selected at runtime - used for generating monitoring thumbnails
+class VEYON_CORE_EXPORT ImageScaler
+{
+public:
+	static bool canScale( const QImage& source, QSize size );
+
+	// falls back to QImage::scaled() for images which can't be scaled by box filter
+	static QImage scaled( const QImage& source, QSize size );
+
+	// scales given area of destination image only, canScale( source, destination.size() ) has
+	// to be true and destination has to be of format QImage::Format_RGB32
+	static void scale( const QImage& source, QImage& destination, const QRect& destinationArea );
+
+} ;
+
+#endif
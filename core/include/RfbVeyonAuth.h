@@ -55,6 +55,9 @@ public:
 		// client has to prove its authenticity by knowing common token
 		Token,
 
+		// client proves possession of a ticket received after previous DSA or logon authentication
+		Ticket,
+
 		AuthTypeCount
 
 	} Type;
@@ -0,0 +1,55 @@
+/*
+ * ScaledFramebufferMessage.h - declaration of ScaledFramebufferMessage class
+ *
+ * Copyright (c) 2017 Tobias Junghans <tobydox@users.sf.net>
+ *
+ * This file is part of Veyon - http://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef SCALED_FRAMEBUFFER_MESSAGE_H
+#define SCALED_FRAMEBUFFER_MESSAGE_H
+
+#include "Feature.h"
+
+// feature message which tells the service to deliver framebuffer updates
+// pre-scaled to given size instead of forwarding the full framebuffer - services
+// not knowing this message simply ignore it and keep forwarding the framebuffer
+class ScaledFramebufferMessage
+{
+public:
+	enum Commands
+	{
+		SetScaledSize
+	};
+
+	enum Arguments
+	{
+		Width,
+		Height,
+		UpdateInterval
+	};
+
+	static Feature::Uid featureUid()
+	{
+		return Feature::Uid( "aefcf92a-6198-4ff5-aaa7-dd2473f9ca10" );
+	}
+
+} ;
+
+#endif
@@ -25,6 +25,7 @@
 #ifndef USER_SESSION_CONTROL_H
 #define USER_SESSION_CONTROL_H
 
+#include <QPointer>
 #include <QReadWriteLock>
 
 #include "FeaturePluginInterface.h"
@@ -41,6 +42,7 @@ public:
 	~UserSessionControl() override;
 
 	bool getUserSessionInfo( const ComputerControlInterfaceList& computerControlInterfaces );
+	bool subscribeUserSessionInfo( const ComputerControlInterfaceList& computerControlInterfaces );
 
 	Plugin::Uid uid() const override
 	{
@@ -95,20 +97,32 @@ public:
 
 	bool handleWorkerFeatureMessage( const FeatureMessage& message ) override;
 
+private slots:
+	void pushUserSessionInfo();
+
 private:
 	enum Commands
 	{
 		GetInfo,
 		LogonUser,
-		LogoutUser
+		LogoutUser,
+		SubscribeInfo
 	};
 
 	enum Arguments
 	{
 		UserName,
+		SubscriptionActive,
+	};
+
+	enum {
+		UserInfoUpdateInterval = 5000,
 	};
 
+	void removeSubscriber( const QIODevice* ioDevice );
+	void sendUserSessionInfo( QIODevice* ioDevice, FeatureMessage::Command command );
 	void queryUserInformation();
+	void updateUserInformation();
 	bool confirmFeatureExecution( const Feature& feature, QWidget* parent );
 
 	Feature m_userSessionInfoFeature;
@@ -122,6 +136,8 @@ private:
 	QString m_userName;
 	QString m_userFullName;
 
+	QList<QPointer<QIODevice> > m_subscribers;
+
 };
 
 #endif // USER_SESSION_CONTROL_H
@@ -59,6 +59,7 @@ public slots:
 	void setTrayIconHidden( bool );
 	void setServiceAutostart( bool );
 	void setSoftwareSASEnabled( bool );
+	void setSharedFramebufferSessionEnabled( bool );
 	void setLogLevel( int );
 	void setLogToStdErr( bool );
 	void setLogToSystem( bool );
@@ -91,6 +92,8 @@ public slots:
 	void setEnforceSelectedModeForClients( bool );
 	void setOpenComputerManagementAtStart( bool );
 	void setConfirmDangerousActions( bool );
+	void setConnectionPoolEnabled( bool );
+	void setServerSideThumbnailScalingEnabled( bool );
 	void setKeyAuthenticationEnabled( bool );
 	void setLogonAuthenticationEnabled( bool );
 	void setPrivateKeyBaseDir( const QString & );
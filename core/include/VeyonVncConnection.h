@@ -30,17 +30,25 @@
 
 #include "VeyonCore.h"
 
+#include <QAtomicInt>
+#include <QElapsedTimer>
 #include <QMutex>
+#include <QPointer>
 #include <QQueue>
 #include <QReadWriteLock>
+#include <QSharedPointer>
 #include <QThread>
+#include <QTime>
 #include <QTimer>
+#include <QVector>
 #include <QWaitCondition>
 #include <QImage>
 
 #include "RfbVeyonAuth.h"
 #include "SocketDevice.h"
 
+class HostReachabilityProber;
+class VncConnectionPool;
 
 class MessageEvent	// clazy:exclude=copyable-polymorphic
 {
@@ -80,6 +88,7 @@ public:
 	~VeyonVncConnection() override;
 
 	QImage image() const;
+	void startPooled( VncConnectionPool* connectionPool );
 	void stop( bool deleteAfterFinished = false );
 	void reset( const QString &host );
 	void setHost( const QString &host );
@@ -92,7 +101,7 @@ public:
 
 	bool isConnected() const
 	{
-		return state() == Connected && isRunning();
+		return state() == Connected && isActive();
 	}
 
 	const QString &host() const
@@ -120,6 +129,13 @@ public:
 		return m_quality;
 	}
 
+	void setReachabilityProber( const QSharedPointer<HostReachabilityProber>& reachabilityProber )
+	{
+		m_reachabilityProber = reachabilityProber;
+	}
+
+	void retryConnectionNow();
+
 	void enqueueEvent( MessageEvent *e );
 
 	const rfbClient *getRfbClient() const
@@ -143,14 +159,7 @@ public:
 		return m_frameBufferValid;
 	}
 
-	void setScaledSize( QSize s )
-	{
-		if( m_scaledSize != s )
-		{
-			m_scaledSize = s;
-			m_scaledScreenNeedsUpdate = true;
-		}
-	}
+	void setScaledSize( QSize scaledSize );
 
 	QImage scaledScreen()
 	{
@@ -196,25 +205,59 @@ public slots:
 
 
 protected:
+	bool event( QEvent* event ) override;
 	void run() override;
 
 
 private:
 	enum {
 		InitialFrameBufferTimeout = 15000,	/**< A server has to send an initial framebuffer within given timeout in ms */
-		ThreadTerminationTimeout = 10000
+		ThreadTerminationTimeout = 10000,
+		DefaultRetryInterval = 1000,
+		MaximumRetryInterval = 20000,	/**< upper limit for backoff of offline hosts - keeps them watched by HostReachabilityProber */
+		MaximumRetryBackoffExponent = 5,
+		DefaultPollInterval = 500,
+		ResumptionTicketExpiryMargin = 10000,	/**< stop using resumption tickets that long before they expire */
+		ResumptionTicketSecretSize = 32,	/**< size of ticket secrets chosen by us during logon authentication */
+		ScaledScreenBlockSize = 16,	/**< size of blocks in scaled screen which are rescaled individually */
+		MaximumDirtyRectCount = 64	/**< collapse dirty rectangles into their bounding rectangle beyond this count */
 	};
 
+	bool isActive() const
+	{
+		return isRunning() || m_attachedToPool.loadAcquire();
+	}
+
 	void establishConnection();
 	void handleConnection();
 	void closeConnection();
 
+	// single steps of connection handling shared by own thread and VncConnectionPool
+	bool tryConnect();
+	void beginConnection();
+	bool requestInitialFramebuffer();
+	bool handleServerMessages();
+	void requestPeriodicFullUpdate();
+	int retryInterval();
+	int retryJitter( int range );
+	int pollInterval() const;
+	bool isHostReachable();
+
+	bool isServerSideScalingEnabled() const;
+	void requestScaledFramebuffer();
+
 	void setState( State state );
 
 	void finishFrameBufferUpdate();
+	void addDirtyRect( const QRect& rect );
+	void rescaleDirtyBlocks( const QVector<QRect>& dirtyRects );
+	void rescaleArea( const QRect& scaledArea );
 
 	void sendEvents();
 
+	bool hasValidResumptionTicket() const;
+	void receiveResumptionTicket( QIODevice* ioDevice, const QByteArray& secret );
+
 	// hooks for LibVNCClient
 	static int8_t hookInitFrameBuffer( rfbClient *cl );
 	static void hookUpdateFB( rfbClient *cl, int x, int y, int w, int h );
@@ -228,10 +271,16 @@ private:
 	static void framebufferCleanup( void* framebuffer );
 
 	bool m_serviceReachable;
+	QAtomicInt m_failedConnectAttempts;
+	quint32 m_retryJitterState;
 	bool m_frameBufferInitialized;
 	bool m_frameBufferValid;
 	rfbClient *m_cl;
 	RfbVeyonAuth::Type m_veyonAuthType;
+	QByteArray m_resumptionTicket;
+	QByteArray m_resumptionTicketSecret;
+	QElapsedTimer m_resumptionTicketTimer;
+	int m_resumptionTicketLifetime;
 	QualityLevels m_quality;
 	QString m_host;
 	int m_port;
@@ -246,9 +295,21 @@ private:
 	bool m_scaledScreenNeedsUpdate;
 	QImage m_scaledScreen;
 	QSize m_scaledSize;
+	QSize m_scaledSourceSize;
+	QMutex m_dirtyRectsLock;
+	QVector<QRect> m_dirtyRects;
 
 	volatile State m_state;
 
+	QTime m_connectionTime;
+	QTime m_lastFullUpdateTime;
+
+	QPointer<VncConnectionPool> m_connectionPool;
+	QSharedPointer<HostReachabilityProber> m_reachabilityProber;
+	QAtomicInt m_attachedToPool;
+
+	friend class VncConnectionPool;
+	friend class VncConnectionPoolWorker;
 
 } ;
 
@@ -26,10 +26,11 @@
 #define VNC_CLIENT_PROTOCOL_H
 
 #include <QRect>
+#include <QRegion>
 
 #include "VeyonCore.h"
 
-class QBuffer;
+class QIODevice;
 class QTcpSocket;
 
 class VEYON_CORE_EXPORT VncClientProtocol
@@ -78,6 +79,18 @@ public:
 
 	bool receiveMessage();
 
+	// write completely received framebuffer updates to given device right away
+	// instead of handing them out via lastMessage()
+	void setFramebufferUpdateForwardingDevice( QIODevice* device )
+	{
+		m_framebufferUpdateForwardingDevice = device;
+	}
+
+	bool isLastMessageForwarded() const
+	{
+		return m_lastMessageForwarded;
+	}
+
 	const QByteArray& lastMessage() const
 	{
 		return m_lastMessage;
@@ -93,7 +106,30 @@ public:
 		return m_lastUpdatedRect;
 	}
 
+	// framebuffer update consisting of the cursor shape and position rects of
+	// the last update only - empty if it did not contain any of them
+	const QByteArray& lastCursorUpdateMessage() const
+	{
+		return m_lastCursorUpdateMessage;
+	}
+
 private:
+	// state of framebuffer update currently being received - updates are parsed
+	// incrementally so every byte is processed only once regardless of how many
+	// chunks it arrives in
+	typedef enum FramebufferUpdateStates {
+		UpdateMessageHeader,
+		UpdateRectHeader,
+		UpdateRectPayload,
+		UpdateRectFinished,
+		UpdateRREHeader,
+		UpdateCoRREHeader,
+		UpdateZlibHeader,
+		UpdateZRLEHeader,
+		UpdateHextileTileHeader,
+		UpdateHextileSubrectCount
+	} FramebufferUpdateState;
+
 	bool readProtocol();
 	bool receiveSecurityTypes();
 	bool receiveSecurityChallenge();
@@ -109,16 +145,17 @@ private:
 
 	bool readMessage( qint64 size );
 
-	bool handleRect( QBuffer& buffer, const rfbFramebufferUpdateRectHeader& rectHeader );
-	bool handleRectEncodingRRE( QBuffer& buffer, int bytesPerPixel );
-	bool handleRectEncodingCoRRE( QBuffer& buffer, int bytesPerPixel );
-	bool handleRectEncodingHextile( QBuffer& buffer,
-									const rfbFramebufferUpdateRectHeader rectHeader,
-									int bytesPerPixel );
-	bool handleRectEncodingZlib( QBuffer& buffer );
-	bool handleRectEncodingZRLE( QBuffer& buffer );
+	bool beginRect();
+	void beginHextileTile();
+	bool finishRect();
+	bool finishFramebufferUpdate();
+	bool readUpdateData( void* data, qint64 size );
+	bool readUpdatePayload();
+	void expectUpdatePayload( qint64 size, FramebufferUpdateState nextState );
+	void resetFramebufferUpdate();
 
 	static bool isPseudoEncoding( const rfbFramebufferUpdateRectHeader& header );
+	static bool isCursorEncoding( const rfbFramebufferUpdateRectHeader& header );
 
 	QTcpSocket* m_socket;
 	State m_state;
@@ -134,6 +171,24 @@ private:
 
 	QByteArray m_lastMessage;
 	QRect m_lastUpdatedRect;
+	bool m_lastMessageForwarded;
+	QByteArray m_lastCursorUpdateMessage;
+
+	QIODevice* m_framebufferUpdateForwardingDevice;
+
+	FramebufferUpdateState m_updateState;
+	FramebufferUpdateState m_updateStateAfterPayload;
+	QByteArray m_updateMessage;
+	int m_updateRectsRemaining;
+	rfbFramebufferUpdateRectHeader m_updateRectHeader;
+	int m_updateRectOffset;
+	qint64 m_updatePayloadRemaining;
+	int m_hextileX;
+	int m_hextileY;
+	uint8_t m_hextileSubencoding;
+	QRegion m_updatedRegion;
+	QByteArray m_cursorUpdateRects;
+	int m_cursorUpdateRectCount;
 
 } ;
 
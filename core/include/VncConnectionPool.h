@@ -0,0 +1,205 @@
+/*
+ * VncConnectionPool.h - declaration of VncConnectionPool class
+ *
+ * Copyright (c) 2017 Tobias Junghans <tobydox@users.sf.net>
+ *
+ * This file is part of Veyon - http://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef VNC_CONNECTION_POOL_H
+#define VNC_CONNECTION_POOL_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QQueue>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+#include <QWaitCondition>
+
+#include "VeyonCore.h"
+
+class VeyonVncConnection;
+class VncConnectionPoolWorker;
+
+// runs many VeyonVncConnection instances in a few worker threads (epoll + timer wheel)
+// instead of one thread per connection - blocking connection attempts and message
+// reads are run in separate bounded thread pools so offline or stalling hosts do
+// not hold up other connections
+class VEYON_CORE_EXPORT VncConnectionPool : public QObject
+{
+	Q_OBJECT
+public:
+	explicit VncConnectionPool( int workerCount = 0, QObject* parent = nullptr );
+	~VncConnectionPool() override;
+
+	static bool isSupported();
+
+	bool addConnection( VeyonVncConnection* connection );
+	void removeConnection( VeyonVncConnection* connection, bool deleteAfterRemoval, bool waitForRemoval );
+	void wakeUp( VeyonVncConnection* connection );
+	void reschedule( VeyonVncConnection* connection );
+	void retryNow( VeyonVncConnection* connection );
+
+	int connectionCount() const;
+
+private:
+	enum {
+		MaximumConcurrentConnectAttempts = 16,
+		MaximumConcurrentMessageHandlers = 32
+	};
+
+	VncConnectionPoolWorker* workerOf( VeyonVncConnection* connection ) const;
+	void connectionAdded( VeyonVncConnection* connection, VncConnectionPoolWorker* worker );
+	void connectionRemoved( VeyonVncConnection* connection );
+
+	QThreadPool m_connectThreadPool;
+	QThreadPool m_messageThreadPool;
+	QVector<VncConnectionPoolWorker *> m_workers;
+	int m_nextWorker;
+
+	mutable QMutex m_connectionsLock;
+	QWaitCondition m_connectionRemovedCondition;
+	QHash<VeyonVncConnection *, VncConnectionPoolWorker *> m_connections;
+
+	friend class VncConnectionPoolWorker;
+
+} ;
+
+
+
+class VncConnectionPoolWorker : public QThread
+{
+public:
+	VncConnectionPoolWorker( VncConnectionPool* pool, QThreadPool* connectThreadPool, QThreadPool* messageThreadPool );
+	~VncConnectionPoolWorker() override;
+
+	bool isValid() const
+	{
+		return m_epollFd >= 0 && m_wakeUpFd >= 0;
+	}
+
+	void addConnection( VeyonVncConnection* connection );
+	void removeConnection( VeyonVncConnection* connection, bool deleteAfterRemoval );
+	void wakeUp( VeyonVncConnection* connection );
+	void reschedule( VeyonVncConnection* connection );
+	void retryNow( VeyonVncConnection* connection );
+	void performConnectAttempt( VeyonVncConnection* connection );
+	void performMessageHandling( VeyonVncConnection* connection );
+
+	void prepareShutdown();
+	void shutdown();
+
+protected:
+	void run() override;
+
+private:
+	enum {
+		TimerWheelResolution = 10,	/**< granularity of timer wheel in ms */
+		TimerWheelSlotCount = 512,
+		MaximumEventCount = 64
+	};
+
+	struct Entry
+	{
+		enum Phases
+		{
+			Idle,
+			ConnectPending,
+			Connecting,
+			Connected,
+			Receiving	/**< messages are being read in message thread pool */
+		} ;
+
+		VeyonVncConnection* connection;
+		Phases phase;
+		bool watched;
+		bool removalRequested;
+		bool deleteAfterRemoval;
+		bool timerScheduled;
+		bool timerDeferred;
+		qint64 timerTick;
+	} ;
+
+	struct Command
+	{
+		enum Types
+		{
+			Add,
+			Remove,
+			WakeUp,
+			Reschedule,
+			RetryNow,
+			ConnectFinished,
+			MessagesHandled
+		} ;
+
+		Types type;
+		VeyonVncConnection* connection;
+		bool flag;
+	} ;
+
+	void enqueueCommand( Command::Types type, VeyonVncConnection* connection, bool flag = false );
+	void processCommands();
+	void signalWakeUp();
+	void clearWakeUp();
+
+	void startConnecting( Entry* entry );
+	void handleConnectFinished( Entry* entry, bool connected );
+	void handleTimer( Entry* entry );
+	void handleReadable( Entry* entry );
+	void handleMessagesHandled( Entry* entry, bool success );
+	void interruptReceiving( Entry* entry );
+	void waitForMessageHandlers();
+	void disconnectEntry( Entry* entry );
+	void finishRemoval( Entry* entry );
+
+	void armSocket( Entry* entry );
+	void unwatchSocket( Entry* entry );
+
+	void scheduleTimer( Entry* entry, int msecs );
+	void cancelTimer( Entry* entry );
+	void processExpiredTimers();
+	int nextTimerTimeout() const;
+	qint64 currentTick() const;
+
+	VncConnectionPool* m_pool;
+	QThreadPool* m_connectThreadPool;
+	QThreadPool* m_messageThreadPool;
+
+	int m_epollFd;
+	int m_wakeUpFd;
+	bool m_shutdownPrepared;
+	volatile bool m_shutdownRequested;
+
+	QMutex m_commandLock;
+	QQueue<Command> m_commands;
+
+	QHash<VeyonVncConnection *, Entry *> m_entries;
+	int m_receivingCount;
+
+	QElapsedTimer m_clock;
+	qint64 m_processedTick;
+	int m_scheduledTimerCount;
+	QVector<QList<Entry *> > m_timerWheel;
+
+} ;
+
+#endif
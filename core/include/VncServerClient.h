@@ -38,6 +38,8 @@ public:
 		AuthChallenge,
 		AuthPassword,
 		AuthToken,
+		AuthTicket,
+		AuthPending,
 		AuthFinishedSuccess,
 		AuthFinishedFail,
 	} AuthState;
@@ -56,6 +58,7 @@ public:
 		m_protocolState( VncServerProtocol::Disconnected ),
 		m_authState( AuthInit ),
 		m_authType( RfbVeyonAuth::Invalid ),
+		m_resumptionTicketRequested( false ),
 		m_accessControlState( AccessControlInit ),
 		m_username(),
 		m_hostAddress(),
@@ -93,6 +96,16 @@ public:
 		m_authType = authType;
 	}
 
+	bool resumptionTicketRequested() const
+	{
+		return m_resumptionTicketRequested;
+	}
+
+	void setResumptionTicketRequested( bool requested )
+	{
+		m_resumptionTicketRequested = requested;
+	}
+
 	AccessControlState accessControlState() const
 	{
 		return m_accessControlState;
@@ -149,18 +162,26 @@ public:
 	}
 
 public slots:
+	void finishAuthentication( AuthState authState )
+	{
+		m_authState = authState;
+		emit authenticationFinished( this );
+	}
+
 	void finishAccessControl()
 	{
 		emit accessControlFinished( this );
 	}
 
 signals:
+	void authenticationFinished( VncServerClient* );
 	void accessControlFinished( VncServerClient* );
 
 private:
 	VncServerProtocol::State m_protocolState;
 	AuthState m_authState;
 	RfbVeyonAuth::Type m_authType;
+	bool m_resumptionTicketRequested;
 	AccessControlState m_accessControlState;
 	QElapsedTimer m_accessControlTimer;
 	QString m_username;
@@ -90,6 +90,7 @@ private:
 	bool receiveAuthenticationMessage();
 
 	bool processAuthentication( VariantArrayMessage& message );
+	bool finishAuthentication();
 	bool processAccessControl();
 
 	bool processFramebufferInit();
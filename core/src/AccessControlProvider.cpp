@@ -75,6 +75,18 @@ QStringList AccessControlProvider::rooms() const
 AccessControlProvider::AccessResult AccessControlProvider::checkAccess( const QString& accessingUser,
 																		const QString& accessingComputer,
 																		const QStringList& connectedUsers )
+{
+	return checkAccess( accessingUser, accessingComputer,
+						VeyonCore::platform().userInfoFunctions().loggedOnUser(),
+						connectedUsers );
+}
+
+
+
+AccessControlProvider::AccessResult AccessControlProvider::checkAccess( const QString& accessingUser,
+																		const QString& accessingComputer,
+																		const QString& localUser,
+																		const QStringList& connectedUsers )
 {
 	if( VeyonCore::config().isAccessRestrictedToUserGroups() )
 	{
@@ -87,7 +99,7 @@ AccessControlProvider::AccessResult AccessControlProvider::checkAccess( const QS
 	{
 		auto action = processAccessControlRules( accessingUser,
 												 accessingComputer,
-												 VeyonCore::platform().userInfoFunctions().loggedOnUser(),
+												 localUser,
 												 QHostInfo::localHostName(),
 												 connectedUsers );
 		switch( action )
@@ -37,7 +37,12 @@ ComputerControlInterface::ComputerControlInterface( const Computer &computer,
 	m_computer( computer ),
 	m_state( Disconnected ),
 	m_user(),
+	m_activeFeatures(),
+	m_designatedModeFeature(),
+	m_userUpdatesPushed( false ),
+	m_activeFeatureUpdatesPushed( false ),
 	m_scaledScreenSize(),
+	m_updateMode( FullUpdates ),
 	m_vncConnection( nullptr ),
 	m_coreConnection( nullptr ),
 	m_builtinFeatures( nullptr ),
@@ -54,7 +59,8 @@ ComputerControlInterface::~ComputerControlInterface()
 
 
 
-void ComputerControlInterface::start( QSize scaledScreenSize, BuiltinFeatures* builtinFeatures )
+void ComputerControlInterface::start( QSize scaledScreenSize, BuiltinFeatures* builtinFeatures, VncConnectionPool* connectionPool,
+									  const QSharedPointer<HostReachabilityProber>& reachabilityProber )
 {
 	m_scaledScreenSize = scaledScreenSize;
 	m_builtinFeatures = builtinFeatures;
@@ -65,21 +71,26 @@ void ComputerControlInterface::start( QSize scaledScreenSize, BuiltinFeatures* b
 		m_vncConnection->setHost( m_computer.hostAddress() );
 		m_vncConnection->setQuality( VeyonVncConnection::ThumbnailQuality );
 		m_vncConnection->setScaledSize( m_scaledScreenSize );
-		m_vncConnection->setFramebufferUpdateInterval( FramebufferUpdateInterval );
-		m_vncConnection->start();
+		m_vncConnection->setFramebufferUpdateInterval( framebufferUpdateInterval() );
+		m_vncConnection->setReachabilityProber( reachabilityProber );
+		m_vncConnection->startPooled( connectionPool );
 
 		m_coreConnection = new VeyonCoreConnection( m_vncConnection );
 
 		connect( m_vncConnection, &VeyonVncConnection::framebufferUpdateComplete, this, &ComputerControlInterface::setScreenUpdateFlag );
-		connect( m_vncConnection, &VeyonVncConnection::framebufferUpdateComplete ,this, &ComputerControlInterface::updateUser );
-		connect( m_vncConnection, &VeyonVncConnection::framebufferUpdateComplete, this, &ComputerControlInterface::updateActiveFeatures );
+		connect( m_vncConnection, &VeyonVncConnection::framebufferUpdateComplete, this, &ComputerControlInterface::pollServiceState );
 
 		connect( m_vncConnection, &VeyonVncConnection::stateChanged, this, &ComputerControlInterface::updateState );
-		connect( m_vncConnection, &VeyonVncConnection::stateChanged, this, &ComputerControlInterface::updateUser );
-		connect( m_vncConnection, &VeyonVncConnection::stateChanged, this, &ComputerControlInterface::updateActiveFeatures );
+		connect( m_vncConnection, &VeyonVncConnection::stateChanged, this, &ComputerControlInterface::subscribeServiceState );
 
 		connect( m_coreConnection, &VeyonCoreConnection::featureMessageReceived,
 				 this, &ComputerControlInterface::handleFeatureMessage );
+
+		if( reachabilityProber )
+		{
+			connect( reachabilityProber.data(), &HostReachabilityProber::reachabilityChanged,
+					 this, &ComputerControlInterface::handleReachabilityChange, Qt::UniqueConnection );
+		}
 	}
 	else
 	{
@@ -123,6 +134,23 @@ void ComputerControlInterface::setScaledScreenSize( QSize scaledScreenSize )
 
 
 
+void ComputerControlInterface::setUpdateMode( UpdateMode updateMode )
+{
+	if( updateMode == m_updateMode )
+	{
+		return;
+	}
+
+	m_updateMode = updateMode;
+
+	if( m_vncConnection )
+	{
+		m_vncConnection->setFramebufferUpdateInterval( framebufferUpdateInterval() );
+	}
+}
+
+
+
 QImage ComputerControlInterface::scaledScreen() const
 {
 	if( m_vncConnection && m_vncConnection->isConnected() )
@@ -190,6 +218,16 @@ void ComputerControlInterface::sendFeatureMessage( const FeatureMessage& feature
 
 
 
+void ComputerControlInterface::retryConnectionNow()
+{
+	if( m_vncConnection )
+	{
+		m_vncConnection->retryConnectionNow();
+	}
+}
+
+
+
 void ComputerControlInterface::updateState()
 {
 	if( m_vncConnection )
@@ -246,7 +284,74 @@ void ComputerControlInterface::updateActiveFeatures()
 
 
 
+void ComputerControlInterface::subscribeServiceState()
+{
+	// the service pushes user and feature changes to subscribers on its own
+	// once it has acknowledged the subscriptions for the new connection
+	m_userUpdatesPushed = false;
+	m_activeFeatureUpdatesPushed = false;
+
+	if( m_vncConnection && m_coreConnection && state() == Connected )
+	{
+		m_builtinFeatures->userSessionControl().subscribeUserSessionInfo( ComputerControlInterfaceList( { this } ) );
+		m_builtinFeatures->featureControl().subscribeActiveFeatures( ComputerControlInterfaceList( { this } ) );
+	}
+	else
+	{
+		setUser( QString() );
+		setActiveFeatures( {} );
+	}
+}
+
+
+
+void ComputerControlInterface::pollServiceState()
+{
+	// fall back to querying services without subscription support
+	if( m_userUpdatesPushed == false )
+	{
+		updateUser();
+	}
+
+	if( m_activeFeatureUpdatesPushed == false )
+	{
+		updateActiveFeatures();
+	}
+}
+
+
+
+void ComputerControlInterface::handleReachabilityChange( const QString& host, int port,
+														 HostReachabilityProber::Reachability reachability )
+{
+	Q_UNUSED(port);
+
+	if( m_vncConnection && host == m_vncConnection->host() &&
+			reachability != HostReachabilityProber::HostOffline &&
+			( m_state == Offline || m_state == ServiceUnreachable ) )
+	{
+		// host or service came up so connect without waiting for backed off retry
+		m_vncConnection->retryConnectionNow();
+	}
+}
+
+
+
 void ComputerControlInterface::handleFeatureMessage( const FeatureMessage& message )
 {
 	emit featureMessageReceived( message, *this );
 }
+
+
+
+int ComputerControlInterface::framebufferUpdateInterval() const
+{
+	switch( m_updateMode )
+	{
+	case ReducedUpdates: return ReducedFramebufferUpdateInterval;
+	case SuspendedUpdates: return SuspendedFramebufferUpdateInterval;
+	default: break;
+	}
+
+	return FramebufferUpdateInterval;
+}
@@ -22,6 +22,8 @@
  *
  */
 
+#include <QTimer>
+
 #include "FeatureControl.h"
 #include "FeatureWorkerManager.h"
 #include "VeyonCore.h"
@@ -33,7 +35,10 @@ FeatureControl::FeatureControl( QObject* parent ) :
 	m_featureControlFeature( Feature( Feature::Service | Feature::Worker | Feature::Builtin,
 									  Feature::Uid( "a0a96fba-425d-414a-aaf4-352b76d7c4f3" ),
 									  tr( "Feature control" ), QString(), QString() ) ),
-	m_features( { m_featureControlFeature } )
+	m_features( { m_featureControlFeature } ),
+	m_featureWorkerManager(),
+	m_subscribers(),
+	m_pushPending( false )
 {
 }
 
@@ -53,6 +58,14 @@ bool FeatureControl::queryActiveFeatures( const ComputerControlInterfaceList& co
 
 
 
+bool FeatureControl::subscribeActiveFeatures( const ComputerControlInterfaceList& computerControlInterfaces )
+{
+	return sendFeatureMessage( FeatureMessage( m_featureControlFeature.uid(), SubscribeActiveFeatures ),
+							   computerControlInterfaces );
+}
+
+
+
 bool FeatureControl::startMasterFeature( const Feature& feature,
 										 const ComputerControlInterfaceList& computerControlInterfaces,
 										 ComputerControlInterface& localComputerControlInterface,
@@ -90,6 +103,13 @@ bool FeatureControl::handleMasterFeatureMessage( const FeatureMessage& message,
 	{
 		computerControlInterface.setActiveFeatures( message.argument( ActiveFeatureList ).toStringList() );
 
+		// services without subscription support answer all commands like a query
+		// and thus never set this argument, so the master keeps polling them
+		if( message.argument( SubscriptionActive ).toBool() )
+		{
+			computerControlInterface.setActiveFeatureUpdatesPushed( true );
+		}
+
 		return true;
 	}
 
@@ -101,16 +121,14 @@ bool FeatureControl::handleMasterFeatureMessage( const FeatureMessage& message,
 bool FeatureControl::handleServiceFeatureMessage( const FeatureMessage& message,
 												  FeatureWorkerManager& featureWorkerManager )
 {
-	Q_UNUSED(featureWorkerManager);
-
 	if( m_featureControlFeature.uid() == message.featureUid() )
 	{
-		FeatureMessage reply( message.featureUid(), message.command() );
-		reply.addArgument( ActiveFeatureList, featureWorkerManager.runningWorkers() );
+		if( message.command() == SubscribeActiveFeatures )
+		{
+			addSubscriber( message.ioDevice(), featureWorkerManager );
+		}
 
-		char rfbMessageType = rfbVeyonFeatureMessage;
-		message.ioDevice()->write( &rfbMessageType, sizeof(rfbMessageType) );
-		reply.send( message.ioDevice() );
+		sendActiveFeatures( message.ioDevice(), message.command(), featureWorkerManager.runningWorkers() );
 
 		return true;
 	}
@@ -126,3 +144,79 @@ bool FeatureControl::handleWorkerFeatureMessage( const FeatureMessage& message )
 
 	return false;
 }
+
+
+
+void FeatureControl::addSubscriber( QIODevice* ioDevice, FeatureWorkerManager& featureWorkerManager )
+{
+	if( m_featureWorkerManager != &featureWorkerManager )
+	{
+		m_featureWorkerManager = &featureWorkerManager;
+
+		connect( m_featureWorkerManager, &FeatureWorkerManager::runningWorkersChanged,
+				 this, &FeatureControl::schedulePushActiveFeatures );
+	}
+
+	if( m_subscribers.contains( ioDevice ) == false )
+	{
+		m_subscribers.append( ioDevice ); // clazy:exclude=reserve-candidates
+	}
+}
+
+
+
+void FeatureControl::schedulePushActiveFeatures()
+{
+	// restarting a worker stops and starts it in a row so collapse
+	// all changes within one event loop iteration into a single push
+	if( m_pushPending == false )
+	{
+		m_pushPending = true;
+		QTimer::singleShot( 0, this, &FeatureControl::pushActiveFeatures );
+	}
+}
+
+
+
+void FeatureControl::pushActiveFeatures()
+{
+	m_pushPending = false;
+
+	if( m_featureWorkerManager.isNull() )
+	{
+		return;
+	}
+
+	const auto activeFeatures = m_featureWorkerManager->runningWorkers();
+
+	for( auto it = m_subscribers.begin(); it != m_subscribers.end(); )
+	{
+		if( it->isNull() || (*it)->isOpen() == false )
+		{
+			it = m_subscribers.erase( it );
+		}
+		else
+		{
+			sendActiveFeatures( *it, SubscribeActiveFeatures, activeFeatures );
+			++it;
+		}
+	}
+}
+
+
+
+void FeatureControl::sendActiveFeatures( QIODevice* ioDevice, FeatureMessage::Command command,
+										 const FeatureUidList& activeFeatures )
+{
+	FeatureMessage reply( m_featureControlFeature.uid(), command );
+	reply.addArgument( ActiveFeatureList, activeFeatures );
+
+	if( command == SubscribeActiveFeatures )
+	{
+		reply.addArgument( SubscriptionActive, true );
+	}
+
+	char rfbMessageType = rfbVeyonFeatureMessage;
+	ioDevice->write( &rfbMessageType, sizeof(rfbMessageType) );
+	reply.send( ioDevice );
+}
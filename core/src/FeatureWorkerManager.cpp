@@ -46,11 +46,6 @@ FeatureWorkerManager::FeatureWorkerManager( FeatureManager& featureManager, QObj
 	{
 		qCritical( "FeatureWorkerManager: can't listen on localhost!" );
 	}
-
-	auto pendingMessagesTimer = new QTimer( this );
-	connect( pendingMessagesTimer, &QTimer::timeout, this, &FeatureWorkerManager::sendPendingMessages );
-
-	pendingMessagesTimer->start( 100 );
 }
 
 
@@ -106,6 +101,8 @@ void FeatureWorkerManager::startWorker( const Feature& feature )
 	m_workersMutex.lock();
 	m_workers[feature.uid()] = worker;
 	m_workersMutex.unlock();
+
+	emit runningWorkersChanged();
 }
 
 
@@ -121,7 +118,9 @@ void FeatureWorkerManager::stopWorker( const Feature &feature )
 
 	m_workersMutex.lock();
 
-	if( m_workers.contains( feature.uid() ) )
+	const bool workerRunning = m_workers.contains( feature.uid() );
+
+	if( workerRunning )
 	{
 		qDebug() << "Stopping worker for feature" << feature.displayName() << feature.uid();
 
@@ -149,6 +148,11 @@ void FeatureWorkerManager::stopWorker( const Feature &feature )
 	}
 
 	m_workersMutex.unlock();
+
+	if( workerRunning )
+	{
+		emit runningWorkersChanged();
+	}
 }
 
 
@@ -157,12 +161,29 @@ void FeatureWorkerManager::sendMessage( const FeatureMessage& message )
 {
 	m_workersMutex.lock();
 
+	bool workerConnected = false;
+
 	if( m_workers.contains( message.featureUid() ) )
 	{
-		m_workers[message.featureUid()].pendingMessages.append( message );
+		auto& worker = m_workers[message.featureUid()];
+		worker.pendingMessages.append( message );
+		workerConnected = worker.socket != nullptr;
 	}
 
 	m_workersMutex.unlock();
+
+	// otherwise pending messages are sent as soon as the worker has connected
+	if( workerConnected )
+	{
+		if( thread() == QThread::currentThread() )
+		{
+			sendPendingMessages();
+		}
+		else
+		{
+			QMetaObject::invokeMethod( this, "sendPendingMessages", Qt::QueuedConnection );
+		}
+	}
 }
 
 
@@ -218,13 +239,22 @@ void FeatureWorkerManager::processConnection( QTcpSocket* socket )
 	// set socket information
 	if( m_workers.contains( message.featureUid() ) )
 	{
+		bool workerConnected = false;
+
 		if( m_workers[message.featureUid()].socket == nullptr )
 		{
 			m_workers[message.featureUid()].socket = socket;
+			workerConnected = true;
 		}
 
 		m_workersMutex.unlock();
 
+		// deliver messages queued while worker was starting up
+		if( workerConnected )
+		{
+			sendPendingMessages();
+		}
+
 		if( message.command() >= 0 )
 		{
 			m_featureManager.handleServiceFeatureMessage( message, *this );
@@ -245,12 +275,15 @@ void FeatureWorkerManager::closeConnection( QTcpSocket* socket )
 {
 	m_workersMutex.lock();
 
+	bool workersRemoved = false;
+
 	for( auto it = m_workers.begin(); it != m_workers.end(); )
 	{
 		if( it.value().socket == socket )
 		{
 			qDebug() << "FeatureWorkerManager::closeConnection(): removing worker after socket has been closed";
 			it = m_workers.erase( it );
+			workersRemoved = true;
 		}
 		else
 		{
@@ -260,6 +293,11 @@ void FeatureWorkerManager::closeConnection( QTcpSocket* socket )
 
 	m_workersMutex.unlock();
 
+	if( workersRemoved )
+	{
+		emit runningWorkersChanged();
+	}
+
 	socket->deleteLater();
 }
 
@@ -0,0 +1,364 @@
+/*
+ * HostReachabilityProber.cpp - implementation of HostReachabilityProber class
+ *
+ * Copyright (c) 2017 Tobias Junghans <tobydox@users.sf.net>
+ *
+ * This file is part of Veyon - http://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include <QMutexLocker>
+#include <QTcpSocket>
+
+#include "HostReachabilityProber.h"
+
+
+HostReachabilityProber::HostReachabilityProber( QObject* parent ) :
+	QObject( parent ),
+	m_thread(),
+	m_worker( new HostReachabilityProberWorker( this ) ),
+	m_resultsLock(),
+	m_resultsAvailable(),
+	m_results(),
+	m_shutdown( false )
+{
+	qRegisterMetaType<Reachability>();
+
+	m_worker->moveToThread( &m_thread );
+
+	connect( this, &HostReachabilityProber::sweepRequested,
+			 m_worker, &HostReachabilityProberWorker::scheduleSweep, Qt::QueuedConnection );
+	connect( &m_thread, &QThread::finished, m_worker, &QObject::deleteLater );
+
+	m_thread.start();
+}
+
+
+
+HostReachabilityProber::~HostReachabilityProber()
+{
+	// release all callers still waiting for results
+	m_resultsLock.lock();
+	m_shutdown = true;
+	m_resultsLock.unlock();
+
+	m_resultsAvailable.wakeAll();
+
+	m_thread.quit();
+	m_thread.wait();
+}
+
+
+
+HostReachabilityProber::Reachability HostReachabilityProber::reachability( const QString& host, int port ) const
+{
+	QMutexLocker locker( &m_resultsLock );
+
+	return m_results.value( Target( host, port ) ).reachability;
+}
+
+
+
+HostReachabilityProber::Reachability HostReachabilityProber::probe( const QString& host, int port )
+{
+	const Target target( host, port );
+
+	QMutexLocker locker( &m_resultsLock );
+
+	auto& result = m_results[target];
+	result.queryTimer.restart();
+
+	if( result.reachability != Unknown && result.probeTimer.isValid() &&
+			result.probeTimer.elapsed() < ResultLifetime )
+	{
+		return result.reachability;
+	}
+
+	const auto probeCount = result.probeCount;
+
+	if( result.probePending == false )
+	{
+		result.probePending = true;
+		emit sweepRequested();
+	}
+
+	QElapsedTimer waitTimer;
+	waitTimer.start();
+
+	while( m_shutdown == false && m_results.value( target ).probeCount == probeCount )
+	{
+		const auto remainingTime = ProbeWaitTimeout - waitTimer.elapsed();
+		if( remainingTime <= 0 ||
+				m_resultsAvailable.wait( &m_resultsLock, static_cast<unsigned long>( remainingTime ) ) == false )
+		{
+			qWarning() << "HostReachabilityProber::probe(): timeout while waiting for probe result of" << host;
+			break;
+		}
+	}
+
+	return m_results.value( target ).reachability;
+}
+
+
+
+void HostReachabilityProber::invalidate( const QString& host )
+{
+	QMutexLocker locker( &m_resultsLock );
+
+	for( auto it = m_results.begin(), end = m_results.end(); it != end; ++it )
+	{
+		if( it.key().first == host )
+		{
+			it->probeTimer.invalidate();
+		}
+	}
+}
+
+
+
+QList<HostReachabilityProber::Target> HostReachabilityProber::takeSweepTargets()
+{
+	QList<Target> targets;
+
+	QMutexLocker locker( &m_resultsLock );
+
+	for( auto it = m_results.begin(); it != m_results.end(); )
+	{
+		auto& result = it.value();
+
+		if( result.probePending )
+		{
+			result.probePending = false;
+			targets.append( it.key() );
+		}
+		else if( result.queryTimer.isValid() == false || result.queryTimer.elapsed() > WatchTimeout )
+		{
+			// nobody is interested in this host anymore
+			it = m_results.erase( it );
+			continue;
+		}
+		else if( result.reachability != ServiceReachable &&
+				 ( result.probeTimer.isValid() == false || result.probeTimer.elapsed() >= SweepInterval ) )
+		{
+			targets.append( it.key() );
+		}
+
+		++it;
+	}
+
+	return targets;
+}
+
+
+
+int HostReachabilityProber::nextSweepDelay() const
+{
+	QMutexLocker locker( &m_resultsLock );
+
+	int delay = -1;
+
+	for( const auto& result : m_results )
+	{
+		if( result.probePending )
+		{
+			return SweepCoalesceDelay;
+		}
+
+		if( result.reachability != ServiceReachable && result.queryTimer.isValid() &&
+				result.queryTimer.elapsed() <= WatchTimeout )
+		{
+			int remainingTime = SweepCoalesceDelay;
+			if( result.probeTimer.isValid() )
+			{
+				remainingTime = qMax<int>( SweepCoalesceDelay, static_cast<int>( SweepInterval - result.probeTimer.elapsed() ) );
+			}
+
+			delay = delay < 0 ? remainingTime : qMin( delay, remainingTime );
+		}
+	}
+
+	return delay;
+}
+
+
+
+void HostReachabilityProber::storeResult( const Target& target, Reachability reachability )
+{
+	m_resultsLock.lock();
+
+	const auto it = m_results.find( target );
+	if( it == m_results.end() )
+	{
+		m_resultsLock.unlock();
+		return;
+	}
+
+	const auto changed = it->reachability != reachability;
+
+	it->reachability = reachability;
+	it->probeTimer.restart();
+	++it->probeCount;
+
+	m_resultsLock.unlock();
+
+	m_resultsAvailable.wakeAll();
+
+	if( changed )
+	{
+		emit reachabilityChanged( target.first, target.second, reachability );
+	}
+}
+
+
+
+HostReachabilityProberWorker::HostReachabilityProberWorker( HostReachabilityProber* prober ) :
+	QObject(),
+	m_prober( prober ),
+	m_sweepTimer( this ),
+	m_timeoutTimer( this ),
+	m_probes()
+{
+	m_sweepTimer.setSingleShot( true );
+
+	m_timeoutTimer.setSingleShot( true );
+	m_timeoutTimer.setInterval( HostReachabilityProber::ProbeTimeout );
+
+	connect( &m_sweepTimer, &QTimer::timeout, this, &HostReachabilityProberWorker::sweep );
+	connect( &m_timeoutTimer, &QTimer::timeout, this, &HostReachabilityProberWorker::abortProbes );
+}
+
+
+
+void HostReachabilityProberWorker::scheduleSweep()
+{
+	// requests arriving during a sweep are picked up as soon as it has finished
+	if( m_probes.isEmpty() == false )
+	{
+		return;
+	}
+
+	if( m_sweepTimer.isActive() == false ||
+			m_sweepTimer.remainingTime() > HostReachabilityProber::SweepCoalesceDelay )
+	{
+		m_sweepTimer.start( HostReachabilityProber::SweepCoalesceDelay );
+	}
+}
+
+
+
+void HostReachabilityProberWorker::sweep()
+{
+	const auto targets = m_prober->takeSweepTargets();
+
+	if( targets.isEmpty() )
+	{
+		finishSweep();
+		return;
+	}
+
+	QList<QTcpSocket *> sockets;
+	sockets.reserve( targets.size() );
+
+	// register all probes first as errors may be reported synchronously while connecting
+	for( const auto& target : targets )
+	{
+		auto socket = new QTcpSocket( this );
+
+		connect( socket, &QTcpSocket::connected, this, [=]() {
+			finishProbe( socket, HostReachabilityProber::ServiceReachable );
+		} );
+		connect( socket, QOverload<QAbstractSocket::SocketError>::of( &QAbstractSocket::error ), this,
+				 [=]( QAbstractSocket::SocketError error ) { handleError( socket, error ); } );
+
+		m_probes[socket] = target;
+		sockets.append( socket );
+	}
+
+	m_timeoutTimer.start();
+
+	for( int i = 0; i < sockets.size(); ++i )
+	{
+		sockets[i]->connectToHost( targets[i].first, static_cast<quint16>( targets[i].second ) );
+	}
+}
+
+
+
+void HostReachabilityProberWorker::finishProbe( QTcpSocket* socket, HostReachabilityProber::Reachability reachability )
+{
+	const auto it = m_probes.find( socket );
+	if( it == m_probes.end() )
+	{
+		return;
+	}
+
+	const auto target = it.value();
+	m_probes.erase( it );
+
+	socket->disconnect( this );
+	socket->abort();
+	socket->deleteLater();
+
+	m_prober->storeResult( target, reachability );
+
+	if( m_probes.isEmpty() )
+	{
+		finishSweep();
+	}
+}
+
+
+
+void HostReachabilityProberWorker::handleError( QTcpSocket* socket, QAbstractSocket::SocketError error )
+{
+	if( error == QAbstractSocket::ConnectionRefusedError )
+	{
+		// host is up and answered but nothing is listening on the service port
+		finishProbe( socket, HostReachabilityProber::ServiceUnreachable );
+	}
+	else
+	{
+		finishProbe( socket, HostReachabilityProber::HostOffline );
+	}
+}
+
+
+
+void HostReachabilityProberWorker::abortProbes()
+{
+	// hosts which did not answer within timeout are considered offline
+	const auto sockets = m_probes.keys();
+
+	for( auto socket : sockets )
+	{
+		finishProbe( socket, HostReachabilityProber::HostOffline );
+	}
+}
+
+
+
+void HostReachabilityProberWorker::finishSweep()
+{
+	m_timeoutTimer.stop();
+
+	const auto delay = m_prober->nextSweepDelay();
+	if( delay >= 0 )
+	{
+		m_sweepTimer.start( delay );
+	}
+}
@@ -0,0 +1,250 @@
+/*
+ * ImageScaler.cpp - implementation of ImageScaler class
+ *
+ * Copyright (c) 2017 Tobias Junghans <tobydox@users.sf.net>
+ *
+ * This file is part of Veyon - http://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include <QVector>
+
+#include "ImageScaler.h"
+
+#if defined(__GNUC__) && ( defined(__i386__) || defined(__x86_64__) )
+#define IMAGE_SCALER_X86
+#include <immintrin.h>
+#endif
+
+
+namespace
+{
+
+// adds all bytes of a source scanline to per-channel sums
+typedef void (*AccumulateFunction)( quint32* sums, const uchar* source, int count );
+
+// averages boxes of per-channel sums into destination pixels
+typedef void (*ReduceFunction)( QRgb* destination, const quint32* sums, const int* columns, int width, int rows );
+
+struct Kernels
+{
+	AccumulateFunction accumulate;
+	ReduceFunction reduce;
+} ;
+
+
+
+void accumulateScalar( quint32* sums, const uchar* source, int count )
+{
+	for( int i = 0; i < count; ++i )
+	{
+		sums[i] += source[i];
+	}
+}
+
+
+
+void reduceScalar( QRgb* destination, const quint32* sums, const int* columns, int width, int rows )
+{
+	for( int x = 0; x < width; ++x )
+	{
+		quint32 channels[4] = { 0, 0, 0, 0 };
+
+		for( int column = columns[x]; column < columns[x+1]; ++column )
+		{
+			for( int channel = 0; channel < 4; ++channel )
+			{
+				channels[channel] += sums[column*4+channel];
+			}
+		}
+
+		const float scale = 1.0f / float( ( columns[x+1] - columns[x] ) * rows );
+
+		uchar pixel[4];
+		for( int channel = 0; channel < 4; ++channel )
+		{
+			pixel[channel] = static_cast<uchar>( float( channels[channel] ) * scale + 0.5f );
+		}
+
+		memcpy( destination + x, pixel, sizeof(pixel) );
+	}
+}
+
+
+
+#ifdef IMAGE_SCALER_X86
+__attribute__((target("sse2")))
+void accumulateSse2( quint32* sums, const uchar* source, int count )
+{
+	const __m128i zero = _mm_setzero_si128();
+
+	int i = 0;
+	for( ; i + 16 <= count; i += 16 )
+	{
+		const __m128i bytes = _mm_loadu_si128( reinterpret_cast<const __m128i *>( source + i ) );
+		const __m128i low = _mm_unpacklo_epi8( bytes, zero );
+		const __m128i high = _mm_unpackhi_epi8( bytes, zero );
+
+		auto s = reinterpret_cast<__m128i *>( sums + i );
+		_mm_storeu_si128( s+0, _mm_add_epi32( _mm_loadu_si128( s+0 ), _mm_unpacklo_epi16( low, zero ) ) );
+		_mm_storeu_si128( s+1, _mm_add_epi32( _mm_loadu_si128( s+1 ), _mm_unpackhi_epi16( low, zero ) ) );
+		_mm_storeu_si128( s+2, _mm_add_epi32( _mm_loadu_si128( s+2 ), _mm_unpacklo_epi16( high, zero ) ) );
+		_mm_storeu_si128( s+3, _mm_add_epi32( _mm_loadu_si128( s+3 ), _mm_unpackhi_epi16( high, zero ) ) );
+	}
+
+	accumulateScalar( sums + i, source + i, count - i );
+}
+
+
+
+__attribute__((target("sse2")))
+void reduceSse2( QRgb* destination, const quint32* sums, const int* columns, int width, int rows )
+{
+	const __m128 half = _mm_set1_ps( 0.5f );
+
+	for( int x = 0; x < width; ++x )
+	{
+		// all four channels of a pixel fit into one register
+		__m128i channels = _mm_setzero_si128();
+
+		for( int column = columns[x]; column < columns[x+1]; ++column )
+		{
+			channels = _mm_add_epi32( channels, _mm_loadu_si128( reinterpret_cast<const __m128i *>( sums + column*4 ) ) );
+		}
+
+		const __m128 scale = _mm_set1_ps( 1.0f / float( ( columns[x+1] - columns[x] ) * rows ) );
+		__m128i pixel = _mm_cvttps_epi32( _mm_add_ps( _mm_mul_ps( _mm_cvtepi32_ps( channels ), scale ), half ) );
+		pixel = _mm_packs_epi32( pixel, pixel );
+		pixel = _mm_packus_epi16( pixel, pixel );
+
+		destination[x] = static_cast<QRgb>( _mm_cvtsi128_si32( pixel ) );
+	}
+}
+
+
+
+__attribute__((target("avx2")))
+void accumulateAvx2( quint32* sums, const uchar* source, int count )
+{
+	int i = 0;
+	for( ; i + 32 <= count; i += 32 )
+	{
+		for( int part = 0; part < 32; part += 8 )
+		{
+			const __m256i values = _mm256_cvtepu8_epi32( _mm_loadl_epi64( reinterpret_cast<const __m128i *>( source + i + part ) ) );
+			auto s = reinterpret_cast<__m256i *>( sums + i + part );
+			_mm256_storeu_si256( s, _mm256_add_epi32( _mm256_loadu_si256( s ), values ) );
+		}
+	}
+
+	accumulateScalar( sums + i, source + i, count - i );
+}
+#endif
+
+
+
+Kernels selectKernels()
+{
+#ifdef IMAGE_SCALER_X86
+	__builtin_cpu_init();
+
+	if( __builtin_cpu_supports( "avx2" ) )
+	{
+		return { accumulateAvx2, reduceSse2 };
+	}
+
+	if( __builtin_cpu_supports( "sse2" ) )
+	{
+		return { accumulateSse2, reduceSse2 };
+	}
+#endif
+
+	return { accumulateScalar, reduceScalar };
+}
+
+}
+
+
+
+bool ImageScaler::canScale( const QImage& source, QSize size )
+{
+	return source.format() == QImage::Format_RGB32 &&
+			size.isEmpty() == false &&
+			size.width() <= source.width() &&
+			size.height() <= source.height();
+}
+
+
+
+QImage ImageScaler::scaled( const QImage& source, QSize size )
+{
+	if( canScale( source, size ) == false )
+	{
+		return source.scaled( size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
+	}
+
+	QImage destination( size, QImage::Format_RGB32 );
+	scale( source, destination, destination.rect() );
+
+	return destination;
+}
+
+
+
+void ImageScaler::scale( const QImage& source, QImage& destination, const QRect& destinationArea )
+{
+	static const Kernels kernels = selectKernels();
+
+	const int sourceWidth = source.width();
+	const int sourceHeight = source.height();
+	const int destinationWidth = destination.width();
+	const int destinationHeight = destination.height();
+
+	const auto area = destinationArea.intersected( destination.rect() );
+	if( area.isEmpty() )
+	{
+		return;
+	}
+
+	// source columns of all boxes relative to the first one
+	QVector<int> columns( area.width() + 1 );
+	const int firstColumn = area.left() * sourceWidth / destinationWidth;
+	for( int x = 0; x <= area.width(); ++x )
+	{
+		columns[x] = ( area.left() + x ) * sourceWidth / destinationWidth - firstColumn;
+	}
+
+	const int sumCount = columns.last() * 4;
+	QVector<quint32> sums( sumCount );
+
+	for( int y = area.top(); y <= area.bottom(); ++y )
+	{
+		const int top = y * sourceHeight / destinationHeight;
+		const int bottom = ( y + 1 ) * sourceHeight / destinationHeight;
+
+		sums.fill( 0 );
+
+		for( int sourceY = top; sourceY < bottom; ++sourceY )
+		{
+			kernels.accumulate( sums.data(), source.constScanLine( sourceY ) + firstColumn * 4, sumCount );
+		}
+
+		kernels.reduce( reinterpret_cast<QRgb *>( destination.scanLine( y ) ) + area.left(),
+						sums.constData(), columns.constData(), area.width(), bottom - top );
+	}
+}
@@ -47,10 +47,13 @@ UserSessionControl::UserSessionControl( QObject* parent ) :
 						 QStringLiteral( ":/resources/system-suspend-hibernate.png" ) ),
 	m_features( { m_userSessionInfoFeature, m_userLogoutFeature } ),
 	m_userInfoQueryThread( new QThread ),
-	m_userInfoQueryTimer( new QTimer )
+	m_userInfoQueryTimer( new QTimer ),
+	m_subscribers()
 {
 	// initialize user info query timer and thread
+	m_userInfoQueryTimer->setInterval( UserInfoUpdateInterval );
 	m_userInfoQueryTimer->moveToThread( m_userInfoQueryThread );
+	connect( m_userInfoQueryTimer, &QTimer::timeout, m_userInfoQueryTimer, [=]() { updateUserInformation(); } );
 	connect( m_userInfoQueryThread, &QThread::finished, m_userInfoQueryThread, &QObject::deleteLater );
 }
 
@@ -72,6 +75,14 @@ bool UserSessionControl::getUserSessionInfo( const ComputerControlInterfaceList&
 
 
 
+bool UserSessionControl::subscribeUserSessionInfo( const ComputerControlInterfaceList& computerControlInterfaces )
+{
+	return sendFeatureMessage( FeatureMessage( m_userSessionInfoFeature.uid(), SubscribeInfo ),
+							   computerControlInterfaces );
+}
+
+
+
 bool UserSessionControl::startMasterFeature( const Feature& feature,
 											 const ComputerControlInterfaceList& computerControlInterfaces,
 											 ComputerControlInterface& localComputerControlInterface,
@@ -117,6 +128,11 @@ bool UserSessionControl::handleMasterFeatureMessage( const FeatureMessage& messa
 	{
 		computerControlInterface.setUser( message.argument( UserName ).toString() );
 
+		if( message.argument( SubscriptionActive ).toBool() )
+		{
+			computerControlInterface.setUserUpdatesPushed( true );
+		}
+
 		return true;
 	}
 
@@ -132,23 +148,25 @@ bool UserSessionControl::handleServiceFeatureMessage( const FeatureMessage& mess
 
 	if( m_userSessionInfoFeature.uid() == message.featureUid() )
 	{
-		FeatureMessage reply( message.featureUid(), message.command() );
-
-		m_userDataLock.lockForRead();
-		if( m_userName.isEmpty() )
+		if( message.command() == SubscribeInfo )
 		{
+			const auto ioDevice = message.ioDevice();
+
+			if( m_subscribers.contains( ioDevice ) == false )
+			{
+				m_subscribers.append( ioDevice ); // clazy:exclude=reserve-candidates
+
+				// stop polling as soon as nobody is interested anymore
+				connect( ioDevice, &QIODevice::aboutToClose, this, [=]() { removeSubscriber( ioDevice ); } );
+				connect( ioDevice, &QObject::destroyed, this, [=]() { removeSubscriber( ioDevice ); } );
+			}
+
+			// keep track of session changes from now on
 			queryUserInformation();
-			reply.addArgument( UserName, QString() );
+			QMetaObject::invokeMethod( m_userInfoQueryTimer, "start", Qt::QueuedConnection );
 		}
-		else
-		{
-			reply.addArgument( UserName, QString( QStringLiteral( "%1 (%2)" ) ).arg( m_userName, m_userFullName ) );
-		}
-		m_userDataLock.unlock();
 
-		char rfbMessageType = rfbVeyonFeatureMessage;
-		message.ioDevice()->write( &rfbMessageType, sizeof(rfbMessageType) );
-		reply.send( message.ioDevice() );
+		sendUserSessionInfo( message.ioDevice(), message.command() );
 
 		return true;
 	}
@@ -171,6 +189,80 @@ bool UserSessionControl::handleWorkerFeatureMessage( const FeatureMessage& messa
 
 
 
+void UserSessionControl::pushUserSessionInfo()
+{
+	for( auto it = m_subscribers.begin(); it != m_subscribers.end(); )
+	{
+		if( it->isNull() || (*it)->isOpen() == false )
+		{
+			it = m_subscribers.erase( it );
+		}
+		else
+		{
+			sendUserSessionInfo( *it, SubscribeInfo );
+			++it;
+		}
+	}
+
+	if( m_subscribers.isEmpty() )
+	{
+		QMetaObject::invokeMethod( m_userInfoQueryTimer, "stop", Qt::QueuedConnection );
+	}
+}
+
+
+
+void UserSessionControl::removeSubscriber( const QIODevice* ioDevice )
+{
+	// pointers of destroyed devices have been reset already
+	for( auto it = m_subscribers.begin(); it != m_subscribers.end(); )
+	{
+		if( it->isNull() || *it == ioDevice )
+		{
+			it = m_subscribers.erase( it );
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	if( m_subscribers.isEmpty() )
+	{
+		QMetaObject::invokeMethod( m_userInfoQueryTimer, "stop", Qt::QueuedConnection );
+	}
+}
+
+
+
+void UserSessionControl::sendUserSessionInfo( QIODevice* ioDevice, FeatureMessage::Command command )
+{
+	FeatureMessage reply( m_userSessionInfoFeature.uid(), command );
+
+	m_userDataLock.lockForRead();
+	if( m_userName.isEmpty() )
+	{
+		queryUserInformation();
+		reply.addArgument( UserName, QString() );
+	}
+	else
+	{
+		reply.addArgument( UserName, QString( QStringLiteral( "%1 (%2)" ) ).arg( m_userName, m_userFullName ) );
+	}
+	m_userDataLock.unlock();
+
+	if( command == SubscribeInfo )
+	{
+		reply.addArgument( SubscriptionActive, true );
+	}
+
+	char rfbMessageType = rfbVeyonFeatureMessage;
+	ioDevice->write( &rfbMessageType, sizeof(rfbMessageType) );
+	reply.send( ioDevice );
+}
+
+
+
 void UserSessionControl::queryUserInformation()
 {
 	if( m_userInfoQueryThread->isRunning() == false )
@@ -180,14 +272,32 @@ void UserSessionControl::queryUserInformation()
 
 	// asynchronously query information about logged on user (which might block
 	// due to domain controller queries and timeouts etc.)
-	m_userInfoQueryTimer->singleShot( 0, m_userInfoQueryTimer, [=]() {
-		const auto userName = VeyonCore::platform().userInfoFunctions().loggedOnUser();
-		const auto userFullName = VeyonCore::platform().userInfoFunctions().fullName( userName );
-		m_userDataLock.lockForWrite();
-		m_userName = userName;
-		m_userFullName = userFullName;
-		m_userDataLock.unlock();
-	} );
+	m_userInfoQueryTimer->singleShot( 0, m_userInfoQueryTimer, [=]() { updateUserInformation(); } );
+}
+
+
+
+void UserSessionControl::updateUserInformation()
+{
+	const auto userName = VeyonCore::platform().userInfoFunctions().loggedOnUser();
+
+	m_userDataLock.lockForRead();
+	const bool userChanged = userName != m_userName;
+	m_userDataLock.unlock();
+
+	if( userChanged == false )
+	{
+		return;
+	}
+
+	const auto userFullName = VeyonCore::platform().userInfoFunctions().fullName( userName );
+	m_userDataLock.lockForWrite();
+	m_userName = userName;
+	m_userFullName = userFullName;
+	m_userDataLock.unlock();
+
+	// subscribers live in the main thread
+	QMetaObject::invokeMethod( this, "pushUserSessionInfo", Qt::QueuedConnection );
 }
 
 
@@ -86,6 +86,7 @@ VeyonConfiguration VeyonConfiguration::defaultConfiguration()
 	c.setDemoServerPort( PortOffsetDemoServer );
 	c.setFirewallExceptionEnabled( true );
 	c.setSoftwareSASEnabled( true );
+	c.setSharedFramebufferSessionEnabled( false );
 
 	c.setUserConfigurationDirectory( QDTNS( QStringLiteral( "$APPDATA/Config" ) ) );
 	c.setScreenshotDirectory( QDTNS( QStringLiteral( "$APPDATA/Screenshots" ) ) );
@@ -25,21 +25,29 @@
  *
  */
 
+#include <QBitArray>
 #include <QBitmap>
+#include <QEvent>
 #include <QHostAddress>
+#include <QMessageAuthenticationCode>
 #include <QMutexLocker>
 #include <QPixmap>
 #include <QTime>
 
 #include "AuthenticationCredentials.h"
 #include "CryptoCore.h"
+#include "FeatureMessage.h"
+#include "HostReachabilityProber.h"
+#include "ImageScaler.h"
 #include "PlatformNetworkFunctions.h"
 #include "PlatformUserInfoFunctions.h"
+#include "ScaledFramebufferMessage.h"
 #include "VeyonConfiguration.h"
 #include "VeyonVncConnection.h"
 #include "LocalSystem.h"
 #include "SocketDevice.h"
 #include "VariantArrayMessage.h"
+#include "VncConnectionPool.h"
 
 extern "C"
 {
@@ -111,6 +119,35 @@ private:
 
 
 
+class ScaledFramebufferEvent : public MessageEvent
+{
+public:
+	ScaledFramebufferEvent( QSize scaledSize, int updateInterval ) :
+		m_scaledSize( scaledSize ),
+		m_updateInterval( updateInterval )
+	{
+	}
+
+	void fire( rfbClient *cl ) override
+	{
+		SocketDevice socketDevice( VeyonVncConnection::libvncClientDispatcher, cl );
+		char messageType = rfbVeyonFeatureMessage;
+		socketDevice.write( &messageType, sizeof(messageType) );
+
+		FeatureMessage( ScaledFramebufferMessage::featureUid(), ScaledFramebufferMessage::SetScaledSize ).
+				addArgument( ScaledFramebufferMessage::Width, m_scaledSize.width() ).
+				addArgument( ScaledFramebufferMessage::Height, m_scaledSize.height() ).
+				addArgument( ScaledFramebufferMessage::UpdateInterval, m_updateInterval ).
+				send( &socketDevice );
+	}
+
+private:
+	QSize m_scaledSize;
+	int m_updateInterval;
+} ;
+
+
+
 
 
 rfbBool VeyonVncConnection::hookInitFrameBuffer( rfbClient *cl )
@@ -154,16 +191,27 @@ rfbBool VeyonVncConnection::hookInitFrameBuffer( rfbClient *cl )
 			//cl->appData.useRemoteCursor = true;
 			break;
 		case ThumbnailQuality:
-			cl->appData.encodingsString = "zrle ultra "
-							"copyrect hextile zlib "
-							"corre rre raw";
+			if( t->isServerSideScalingEnabled() )
+			{
+				// scaled updates are sent with a zlib stream of their own - libvncclient decodes
+				// Zlib and ZRLE rects with the same inflate stream so the VNC server must not
+				// use these encodings for updates sent before scaling has been activated
+				cl->appData.encodingsString = "ultra copyrect hextile corre rre raw";
+			}
+			else
+			{
+				cl->appData.encodingsString = "zrle ultra "
+								"copyrect hextile zlib "
+								"corre rre raw";
+			}
 			cl->appData.compressLevel = 9;
 			cl->appData.qualityLevel = 5;
 			cl->appData.enableJPEG = true;
 			break;
 		default:
+			// demo server re-encodes everything as Tight tiles
 			cl->appData.encodingsString = "zrle ultra copyrect "
-							"hextile zlib corre rre raw";
+							"hextile zlib corre rre raw tight";
 			break;
 	}
 
@@ -181,6 +229,8 @@ void VeyonVncConnection::hookUpdateFB( rfbClient *cl, int x, int y, int w, int h
 
 	if( t )
 	{
+		t->addDirtyRect( QRect( x, y, w, h ) );
+
 		emit t->imageUpdated( x, y, w, h );
 	}
 }
@@ -304,10 +354,16 @@ void VeyonVncConnection::framebufferCleanup( void *framebuffer )
 VeyonVncConnection::VeyonVncConnection( QObject *parent ) :
 	QThread( parent ),
 	m_serviceReachable( false ),
+	m_failedConnectAttempts( 0 ),
+	m_retryJitterState( 0 ),
 	m_frameBufferInitialized( false ),
 	m_frameBufferValid( false ),
 	m_cl( nullptr ),
 	m_veyonAuthType( RfbVeyonAuth::DSA ),
+	m_resumptionTicket(),
+	m_resumptionTicketSecret(),
+	m_resumptionTicketTimer(),
+	m_resumptionTicketLifetime( 0 ),
 	m_quality( DefaultQuality ),
 	m_port( -1 ),
 	m_terminateTimer( this ),
@@ -316,7 +372,15 @@ VeyonVncConnection::VeyonVncConnection( QObject *parent ) :
 	m_scaledScreenNeedsUpdate( false ),
 	m_scaledScreen(),
 	m_scaledSize(),
-	m_state( Disconnected )
+	m_scaledSourceSize(),
+	m_dirtyRectsLock(),
+	m_dirtyRects(),
+	m_state( Disconnected ),
+	m_connectionTime(),
+	m_lastFullUpdateTime(),
+	m_connectionPool( nullptr ),
+	m_reachabilityProber(),
+	m_attachedToPool( 0 )
 {
 	rfbClientLog = hookOutputHandler;
 	rfbClientErr = hookOutputHandler;
@@ -336,6 +400,14 @@ VeyonVncConnection::VeyonVncConnection( QObject *parent ) :
 
 VeyonVncConnection::~VeyonVncConnection()
 {
+	if( m_connectionPool && m_attachedToPool.loadAcquire() )
+	{
+		// deleted directly instead of via stop( true ) or deleteLater() so make sure
+		// no pool worker accesses this object anymore
+		qWarning( "VeyonVncConnection: waiting for removal of pooled connection" );
+		m_connectionPool->removeConnection( this, false, true );
+	}
+
 	stop();
 
 	if( isRunning() )
@@ -356,9 +428,34 @@ VeyonVncConnection::~VeyonVncConnection()
 
 
 
+void VeyonVncConnection::startPooled( VncConnectionPool* connectionPool )
+{
+	if( connectionPool && isRunning() == false )
+	{
+		m_connectionPool = connectionPool;
+		if( m_connectionPool->addConnection( this ) )
+		{
+			return;
+		}
+	}
+
+	// fall back to own thread
+	start();
+}
+
+
+
+
 void VeyonVncConnection::stop( bool deleteAfterFinished )
 {
-	if( isRunning() )
+	if( m_connectionPool && m_attachedToPool.loadAcquire() )
+	{
+		m_scaledScreen = QImage();
+
+		// pool closes the connection asynchronously and deletes us afterwards if requested
+		m_connectionPool->removeConnection( this, deleteAfterFinished, false );
+	}
+	else if( isRunning() )
 	{
 		if( deleteAfterFinished )
 		{
@@ -396,7 +493,7 @@ void VeyonVncConnection::stop( bool deleteAfterFinished )
 
 void VeyonVncConnection::reset( const QString &host )
 {
-	if( m_state != Connected && isRunning() )
+	if( m_state != Connected && isActive() )
 	{
 		setHost( host );
 	}
@@ -404,7 +501,7 @@ void VeyonVncConnection::reset( const QString &host )
 	{
 		stop();
 		setHost( host );
-		start();
+		startPooled( m_connectionPool );
 	}
 }
 
@@ -451,6 +548,28 @@ void VeyonVncConnection::setPort( int port )
 
 
 
+void VeyonVncConnection::retryConnectionNow()
+{
+	// host is expected to come online so reset backoff and discard outdated reachability
+	m_failedConnectAttempts.storeRelease( 0 );
+
+	if( m_reachabilityProber )
+	{
+		m_reachabilityProber->invalidate( m_host );
+	}
+
+	if( m_connectionPool && m_attachedToPool.loadAcquire() )
+	{
+		m_connectionPool->retryNow( this );
+	}
+	else if( m_state != Connected )
+	{
+		m_updateIntervalSleeper.wakeAll();
+	}
+}
+
+
+
 QImage VeyonVncConnection::image() const
 {
 	QReadLocker locker( &m_imgLock );
@@ -459,9 +578,46 @@ QImage VeyonVncConnection::image() const
 
 
 
+void VeyonVncConnection::setScaledSize( QSize scaledSize )
+{
+	if( m_scaledSize != scaledSize )
+	{
+		m_scaledSize = scaledSize;
+		m_scaledScreenNeedsUpdate = true;
+
+		if( isServerSideScalingEnabled() && state() == Connected )
+		{
+			requestScaledFramebuffer();
+		}
+	}
+}
+
+
+
 void VeyonVncConnection::setFramebufferUpdateInterval( int interval )
 {
+	if( interval == m_framebufferUpdateInterval )
+	{
+		return;
+	}
+
 	m_framebufferUpdateInterval = interval;
+
+	// let the server adapt the rate at which it polls its framebuffer
+	if( isServerSideScalingEnabled() && state() == Connected )
+	{
+		requestScaledFramebuffer();
+	}
+
+	// do not wait for the previous (possibly very long) interval to expire
+	if( m_connectionPool && m_attachedToPool.loadAcquire() )
+	{
+		m_connectionPool->reschedule( this );
+	}
+	else
+	{
+		m_updateIntervalSleeper.wakeAll();
+	}
 }
 
 
@@ -478,97 +634,191 @@ void VeyonVncConnection::rescaleScreen()
 	}
 
 	QReadLocker locker( &m_imgLock );
-	m_scaledScreen = m_image.scaled( m_scaledSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
+
+	m_dirtyRectsLock.lock();
+	const auto dirtyRects = m_dirtyRects;
+	m_dirtyRects.clear();
+	m_dirtyRectsLock.unlock();
+
+	if( m_scaledScreen.size() != m_scaledSize ||
+			m_scaledScreen.format() != QImage::Format_RGB32 ||
+			m_scaledSourceSize != m_image.size() )
+	{
+		m_scaledScreen = ImageScaler::scaled( m_image, m_scaledSize ).convertToFormat( QImage::Format_RGB32 );
+		m_scaledSourceSize = m_image.size();
+	}
+	else
+	{
+		rescaleDirtyBlocks( dirtyRects );
+	}
 
 	m_scaledScreenNeedsUpdate = false;
 }
 
 
 
-
-void VeyonVncConnection::run()
+void VeyonVncConnection::addDirtyRect( const QRect& rect )
 {
-	while( isInterruptionRequested() == false )
+	QMutexLocker locker( &m_dirtyRectsLock );
+
+	if( m_dirtyRects.size() >= MaximumDirtyRectCount )
 	{
-		establishConnection();
-		handleConnection();
-		closeConnection();
-	}
+		QRect boundingRect = rect;
+		for( const auto& dirtyRect : qAsConst( m_dirtyRects ) )
+		{
+			boundingRect |= dirtyRect;
+		}
 
-	setState( Disconnected );
+		m_dirtyRects.clear();
+		m_dirtyRects.append( boundingRect );
+	}
+	else
+	{
+		m_dirtyRects.append( rect );
+	}
 }
 
 
 
-void VeyonVncConnection::establishConnection()
+void VeyonVncConnection::rescaleDirtyBlocks( const QVector<QRect>& dirtyRects )
 {
-	QMutex sleeperMutex;
+	const int sourceWidth = m_image.width();
+	const int sourceHeight = m_image.height();
+	const int scaledWidth = m_scaledScreen.width();
+	const int scaledHeight = m_scaledScreen.height();
 
-	setState( Connecting );
+	const int blockColumns = ( scaledWidth + ScaledScreenBlockSize - 1 ) / ScaledScreenBlockSize;
+	const int blockRows = ( scaledHeight + ScaledScreenBlockSize - 1 ) / ScaledScreenBlockSize;
 
-	m_frameBufferValid = false;
-	m_frameBufferInitialized = false;
+	QBitArray dirtyBlocks( blockColumns * blockRows );
 
-	while( isInterruptionRequested() == false && m_state != Connected ) // try to connect as long as the server allows
+	for( const auto& dirtyRect : dirtyRects )
 	{
-		m_cl = rfbGetClient( 8, 3, 4 );
-		m_cl->MallocFrameBuffer = hookInitFrameBuffer;
-		m_cl->canHandleNewFBSize = true;
-		m_cl->GotFrameBufferUpdate = hookUpdateFB;
-		m_cl->FinishedFrameBufferUpdate = hookFinishFrameBufferUpdate;
-		m_cl->HandleCursorPos = hookHandleCursorPos;
-		m_cl->GotCursorShape = hookCursorShape;
-		m_cl->GotXCutText = hookCutText;
-		rfbClientSetClientData( m_cl, nullptr, this );
-
-		m_mutex.lock();
-
-		if( m_port < 0 ) // use default port?
+		const auto rect = dirtyRect.intersected( m_image.rect() );
+		if( rect.isEmpty() )
 		{
-			m_cl->serverPort = VeyonCore::config().primaryServicePort();
+			continue;
 		}
-		else
-		{
-			m_cl->serverPort = m_port;
-		}
-
-		free( m_cl->serverHost );
-		m_cl->serverHost = strdup( m_host.toUtf8().constData() );
-
-		m_mutex.unlock();
-
-		emit newClient( m_cl );
 
-		m_serviceReachable = false;
+		// map to all pixels of scaled screen which depend on given source rectangle
+		const int left = rect.left() * scaledWidth / sourceWidth;
+		const int top = rect.top() * scaledHeight / sourceHeight;
+		const int right = qMin( ( ( rect.right() + 1 ) * scaledWidth + sourceWidth - 1 ) / sourceWidth, scaledWidth ) - 1;
+		const int bottom = qMin( ( ( rect.bottom() + 1 ) * scaledHeight + sourceHeight - 1 ) / sourceHeight, scaledHeight ) - 1;
 
-		if( rfbInitClient( m_cl, nullptr, nullptr ) )
-		{
-			setState( Connected );
-		}
-		else
+		for( int row = top / ScaledScreenBlockSize; row <= bottom / ScaledScreenBlockSize; ++row )
 		{
-			// guess reason why connection failed
-			if( m_serviceReachable == false )
+			for( int column = left / ScaledScreenBlockSize; column <= right / ScaledScreenBlockSize; ++column )
 			{
-				if( VeyonCore::platform().networkFunctions().ping( m_host ) == false )
-				{
-					setState( HostOffline );
-				}
-				else
-				{
-					setState( ServiceUnreachable );
-				}
+				dirtyBlocks.setBit( row * blockColumns + column );
 			}
-			else if( m_frameBufferInitialized == false )
+		}
+	}
+
+	// rescale horizontal runs of dirty blocks at once
+	for( int row = 0; row < blockRows; ++row )
+	{
+		int column = 0;
+		while( column < blockColumns )
+		{
+			if( dirtyBlocks.testBit( row * blockColumns + column ) == false )
 			{
-				setState( AuthenticationFailed );
+				++column;
+				continue;
 			}
-			else
+
+			int runEnd = column + 1;
+			while( runEnd < blockColumns && dirtyBlocks.testBit( row * blockColumns + runEnd ) )
 			{
-				// failed for an unknown reason
-				setState( ConnectionFailed );
+				++runEnd;
 			}
 
+			rescaleArea( QRect( QPoint( column * ScaledScreenBlockSize, row * ScaledScreenBlockSize ),
+								QPoint( qMin( runEnd * ScaledScreenBlockSize, scaledWidth ) - 1,
+										qMin( ( row + 1 ) * ScaledScreenBlockSize, scaledHeight ) - 1 ) ) );
+
+			column = runEnd;
+		}
+	}
+}
+
+
+
+void VeyonVncConnection::rescaleArea( const QRect& scaledArea )
+{
+	if( ImageScaler::canScale( m_image, m_scaledScreen.size() ) )
+	{
+		ImageScaler::scale( m_image, m_scaledScreen, scaledArea );
+		return;
+	}
+
+	const int sourceWidth = m_image.width();
+	const int sourceHeight = m_image.height();
+	const int scaledWidth = m_scaledScreen.width();
+	const int scaledHeight = m_scaledScreen.height();
+
+	// source pixels covered by given area of scaled screen
+	const int left = scaledArea.left() * sourceWidth / scaledWidth;
+	const int top = scaledArea.top() * sourceHeight / scaledHeight;
+	const int right = qMin( ( ( scaledArea.right() + 1 ) * sourceWidth + scaledWidth - 1 ) / scaledWidth, sourceWidth );
+	const int bottom = qMin( ( ( scaledArea.bottom() + 1 ) * sourceHeight + scaledHeight - 1 ) / scaledHeight, sourceHeight );
+
+	// reference source area without copying it
+	const QImage sourceArea( m_image.constScanLine( top ) + left * sizeof(QRgb),
+							 right - left, bottom - top, m_image.bytesPerLine(), QImage::Format_RGB32 );
+
+	const auto scaledSourceArea = sourceArea.scaled( scaledArea.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation ).
+			convertToFormat( QImage::Format_RGB32 );
+
+	for( int y = 0; y < scaledSourceArea.height(); ++y )
+	{
+		memcpy( m_scaledScreen.scanLine( scaledArea.top() + y ) + scaledArea.left() * sizeof(QRgb),
+				scaledSourceArea.constScanLine( y ), scaledSourceArea.width() * sizeof(QRgb) );
+	}
+}
+
+
+
+
+bool VeyonVncConnection::event( QEvent* event )
+{
+	if( event->type() == QEvent::DeferredDelete &&
+			m_connectionPool && m_attachedToPool.loadAcquire() )
+	{
+		// do not block while a connect attempt is running but let the pool delete us afterwards
+		m_connectionPool->removeConnection( this, true, false );
+		return true;
+	}
+
+	return QThread::event( event );
+}
+
+
+
+void VeyonVncConnection::run()
+{
+	while( isInterruptionRequested() == false )
+	{
+		establishConnection();
+		handleConnection();
+		closeConnection();
+	}
+
+	setState( Disconnected );
+}
+
+
+
+void VeyonVncConnection::establishConnection()
+{
+	QMutex sleeperMutex;
+
+	setState( Connecting );
+
+	while( isInterruptionRequested() == false && m_state != Connected ) // try to connect as long as the server allows
+	{
+		if( tryConnect() == false )
+		{
 			// do not sleep when already requested to stop
 			if( isInterruptionRequested() )
 			{
@@ -577,16 +827,7 @@ void VeyonVncConnection::establishConnection()
 
 			// wait a bit until next connect
 			sleeperMutex.lock();
-			if( m_framebufferUpdateInterval > 0 )
-			{
-				m_updateIntervalSleeper.wait( &sleeperMutex,
-												m_framebufferUpdateInterval );
-			}
-			else
-			{
-				// default: retry every second
-				m_updateIntervalSleeper.wait( &sleeperMutex, 1000 );
-			}
+			m_updateIntervalSleeper.wait( &sleeperMutex, retryInterval() );
 			sleeperMutex.unlock();
 		}
 	}
@@ -598,31 +839,14 @@ void VeyonVncConnection::handleConnection()
 {
 	QMutex sleeperMutex;
 
-	QTime connectionTime;
-	connectionTime.restart();
-
-	QTime lastFullUpdateTime;
-	lastFullUpdateTime.restart();
+	beginConnection();
 
 	// Main VNC event loop
 	while( isInterruptionRequested() == false )
 	{
-		if( m_frameBufferValid == false )
+		if( requestInitialFramebuffer() == false )
 		{
-			// initial framebuffer timeout exceeded?
-			if( connectionTime.elapsed() < InitialFrameBufferTimeout )
-			{
-				// not yet so again request initial full framebuffer update
-				SendFramebufferUpdateRequest( m_cl, 0, 0,
-											  framebufferSize().width(), framebufferSize().height(),
-											  false );
-			}
-			else
-			{
-				qDebug( "VeyonVncConnection: InitialFrameBufferTimeout exceeded - disconnecting" );
-				// no so disconnect and try again
-				break;
-			}
+			break;
 		}
 
 		const int i = WaitForMessage( m_cl, 500 );
@@ -630,33 +854,12 @@ void VeyonVncConnection::handleConnection()
 		{
 			break;
 		}
-		else if( i )
+		else if( i && handleServerMessages() == false )
 		{
-			// handle all available messages
-			bool handledOkay = true;
-			do {
-				if( !HandleRFBServerMessage( m_cl ) )
-				{
-					handledOkay = false;
-				}
-			} while( handledOkay && WaitForMessage( m_cl, 0 ) );
-
-			if( handledOkay == false )
-			{
-				break;
-			}
+			break;
 		}
 
-		// ensure that we're not missing updates due to slow update rate therefore
-		// regularly request full updates
-		if( m_framebufferUpdateInterval > 0 &&
-					lastFullUpdateTime.elapsed() > 10*m_framebufferUpdateInterval )
-		{
-			SendFramebufferUpdateRequest( m_cl, 0, 0,
-										  framebufferSize().width(), framebufferSize().height(),
-										  false );
-			lastFullUpdateTime.restart();
-		}
+		requestPeriodicFullUpdate();
 
 		sendEvents();
 
@@ -674,6 +877,236 @@ void VeyonVncConnection::handleConnection()
 
 
 
+bool VeyonVncConnection::tryConnect()
+{
+	m_frameBufferValid = false;
+	m_frameBufferInitialized = false;
+
+	// do not set up a complete connection attempt as long as host is known to be offline
+	if( m_state == HostOffline && m_reachabilityProber && isHostReachable() == false )
+	{
+		m_failedConnectAttempts.ref();
+		return false;
+	}
+
+	m_cl = rfbGetClient( 8, 3, 4 );
+	m_cl->MallocFrameBuffer = hookInitFrameBuffer;
+	m_cl->canHandleNewFBSize = true;
+	m_cl->GotFrameBufferUpdate = hookUpdateFB;
+	m_cl->FinishedFrameBufferUpdate = hookFinishFrameBufferUpdate;
+	m_cl->HandleCursorPos = hookHandleCursorPos;
+	m_cl->GotCursorShape = hookCursorShape;
+	m_cl->GotXCutText = hookCutText;
+	rfbClientSetClientData( m_cl, nullptr, this );
+
+	m_mutex.lock();
+
+	if( m_port < 0 ) // use default port?
+	{
+		m_cl->serverPort = VeyonCore::config().primaryServicePort();
+	}
+	else
+	{
+		m_cl->serverPort = m_port;
+	}
+
+	free( m_cl->serverHost );
+	m_cl->serverHost = strdup( m_host.toUtf8().constData() );
+
+	m_mutex.unlock();
+
+	emit newClient( m_cl );
+
+	m_serviceReachable = false;
+
+	if( rfbInitClient( m_cl, nullptr, nullptr ) )
+	{
+		m_failedConnectAttempts.storeRelease( 0 );
+		setState( Connected );
+		return true;
+	}
+
+	// guess reason why connection failed
+	if( m_serviceReachable == false )
+	{
+		if( isHostReachable() == false )
+		{
+			setState( HostOffline );
+		}
+		else
+		{
+			setState( ServiceUnreachable );
+		}
+
+		m_failedConnectAttempts.ref();
+	}
+	else if( m_frameBufferInitialized == false )
+	{
+		// ticket might have been rejected (e.g. after service restart) so authenticate regularly next time
+		m_resumptionTicket.clear();
+		m_resumptionTicketSecret.clear();
+
+		setState( AuthenticationFailed );
+	}
+	else
+	{
+		// failed for an unknown reason
+		setState( ConnectionFailed );
+	}
+
+	return false;
+}
+
+
+
+void VeyonVncConnection::beginConnection()
+{
+	m_connectionTime.restart();
+	m_lastFullUpdateTime.restart();
+
+	if( isServerSideScalingEnabled() )
+	{
+		requestScaledFramebuffer();
+	}
+}
+
+
+
+bool VeyonVncConnection::requestInitialFramebuffer()
+{
+	if( m_frameBufferValid == false )
+	{
+		// initial framebuffer timeout exceeded?
+		if( m_connectionTime.elapsed() < InitialFrameBufferTimeout )
+		{
+			// not yet so again request initial full framebuffer update
+			SendFramebufferUpdateRequest( m_cl, 0, 0,
+										  framebufferSize().width(), framebufferSize().height(),
+										  false );
+		}
+		else
+		{
+			qDebug( "VeyonVncConnection: InitialFrameBufferTimeout exceeded - disconnecting" );
+			// no so disconnect and try again
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+
+bool VeyonVncConnection::handleServerMessages()
+{
+	// handle all available messages including the ones already read into libvncclient's buffer
+	do {
+		if( !HandleRFBServerMessage( m_cl ) )
+		{
+			return false;
+		}
+	} while( m_cl->buffered > 0 || WaitForMessage( m_cl, 0 ) > 0 );
+
+	return true;
+}
+
+
+
+void VeyonVncConnection::requestPeriodicFullUpdate()
+{
+	// ensure that we're not missing updates due to slow update rate therefore
+	// regularly request full updates
+	if( m_framebufferUpdateInterval > 0 &&
+				m_lastFullUpdateTime.elapsed() > 10*m_framebufferUpdateInterval )
+	{
+		SendFramebufferUpdateRequest( m_cl, 0, 0,
+									  framebufferSize().width(), framebufferSize().height(),
+									  false );
+		m_lastFullUpdateTime.restart();
+	}
+}
+
+
+
+int VeyonVncConnection::retryInterval()
+{
+	// default: retry every second
+	int interval = DefaultRetryInterval;
+
+	if( m_framebufferUpdateInterval > 0 )
+	{
+		interval = m_framebufferUpdateInterval;
+	}
+
+	const auto failedConnectAttempts = m_failedConnectAttempts.loadAcquire();
+
+	// back off exponentially as long as host is offline or service is not reachable
+	if( failedConnectAttempts > 1 && ( m_state == HostOffline || m_state == ServiceUnreachable ) )
+	{
+		const auto exponent = qMin<int>( failedConnectAttempts - 1, MaximumRetryBackoffExponent );
+		interval = qMax( interval, qMin( interval << exponent, static_cast<int>( MaximumRetryInterval ) ) );
+
+		// spread retries of computers which went offline at the same time
+		interval -= retryJitter( interval / 4 + 1 );
+	}
+
+	return interval;
+}
+
+
+
+int VeyonVncConnection::retryJitter( int range )
+{
+	// qrand() is seeded per thread and therefore yields the same sequence in
+	// all connection threads - use a xorshift generator seeded per connection instead
+	if( m_retryJitterState == 0 )
+	{
+		m_retryJitterState = qHash( m_host ) ^ qHash( reinterpret_cast<quintptr>( this ) );
+		if( m_retryJitterState == 0 )
+		{
+			m_retryJitterState = 1;
+		}
+	}
+
+	m_retryJitterState ^= m_retryJitterState << 13;
+	m_retryJitterState ^= m_retryJitterState >> 17;
+	m_retryJitterState ^= m_retryJitterState << 5;
+
+	return static_cast<int>( m_retryJitterState % static_cast<quint32>( range ) );
+}
+
+
+
+int VeyonVncConnection::pollInterval() const
+{
+	if( m_framebufferUpdateInterval > 0 )
+	{
+		return m_framebufferUpdateInterval;
+	}
+
+	return DefaultPollInterval;
+}
+
+
+
+bool VeyonVncConnection::isHostReachable()
+{
+	if( m_reachabilityProber )
+	{
+		const auto port = m_port < 0 ? VeyonCore::config().primaryServicePort() : m_port;
+
+		// probe in batch with all other hosts and reuse recent results
+		const auto reachability = m_reachabilityProber->probe( m_host, port );
+
+		return reachability == HostReachabilityProber::ServiceReachable ||
+				reachability == HostReachabilityProber::ServiceUnreachable;
+	}
+
+	return VeyonCore::platform().networkFunctions().ping( m_host );
+}
+
+
+
 void VeyonVncConnection::closeConnection()
 {
 	if( m_state == Connected && m_cl )
@@ -737,15 +1170,43 @@ void VeyonVncConnection::sendEvents()
 
 
 
+bool VeyonVncConnection::isServerSideScalingEnabled() const
+{
+	return m_quality == ThumbnailQuality &&
+			VeyonCore::config().isServerSideThumbnailScalingEnabled();
+}
+
+
+
+void VeyonVncConnection::requestScaledFramebuffer()
+{
+	if( m_scaledSize.isEmpty() == false )
+	{
+		enqueueEvent( new ScaledFramebufferEvent( m_scaledSize, m_framebufferUpdateInterval ) );
+	}
+}
+
+
+
 void VeyonVncConnection::enqueueEvent( MessageEvent *e )
 {
-	QMutexLocker lock( &m_mutex );
+	m_mutex.lock();
+
 	if( m_state != Connected )
 	{
+		m_mutex.unlock();
 		return;
 	}
 
 	m_eventQueue.enqueue( e );
+
+	m_mutex.unlock();
+
+	// send event immediately instead of waiting for next update interval
+	if( m_connectionPool && m_attachedToPool.loadAcquire() )
+	{
+		m_connectionPool->wakeUp( this );
+	}
 }
 
 
@@ -798,6 +1259,8 @@ void VeyonVncConnection::handleSecTypeVeyon( rfbClient *client )
 
 	qDebug() << "VeyonVncConnection::handleSecTypeVeyon(): received authentication types:" << authTypes;
 
+	VeyonVncConnection *t = (VeyonVncConnection *) rfbClientGetClientData( client, nullptr );
+
 	RfbVeyonAuth::Type chosenAuthType = RfbVeyonAuth::Token;
 	if( authTypes.count() > 0 )
 	{
@@ -806,8 +1269,6 @@ void VeyonVncConnection::handleSecTypeVeyon( rfbClient *client )
 		// look whether the VeyonVncConnection recommends a specific
 		// authentication type (e.g. VeyonAuthHostBased when running as
 		// demo client)
-		VeyonVncConnection *t = (VeyonVncConnection *) rfbClientGetClientData( client, nullptr );
-
 		if( t != nullptr )
 		{
 			for( auto authType : authTypes )
@@ -817,9 +1278,20 @@ void VeyonVncConnection::handleSecTypeVeyon( rfbClient *client )
 					chosenAuthType = authType;
 				}
 			}
+
+			// skip expensive authentication when reconnecting shortly after a previous one
+			if( ( chosenAuthType == RfbVeyonAuth::DSA || chosenAuthType == RfbVeyonAuth::Logon ) &&
+					authTypes.contains( RfbVeyonAuth::Ticket ) && t->hasValidResumptionTicket() )
+			{
+				chosenAuthType = RfbVeyonAuth::Ticket;
+			}
 		}
 	}
 
+	// only servers offering ticket authentication send tickets
+	const bool requestResumptionTicket = t != nullptr && authTypes.contains( RfbVeyonAuth::Ticket ) &&
+			( chosenAuthType == RfbVeyonAuth::DSA || chosenAuthType == RfbVeyonAuth::Logon );
+
 	qDebug() << "VeyonVncConnection::handleSecTypeVeyon(): chose authentication type" << chosenAuthType;
 	VariantArrayMessage authReplyMessage( &socketDevice );
 
@@ -835,6 +1307,8 @@ void VeyonVncConnection::handleSecTypeVeyon( rfbClient *client )
 		authReplyMessage.write( VeyonCore::platform().userInfoFunctions().loggedOnUser() );
 	}
 
+	authReplyMessage.write( requestResumptionTicket );
+
 	authReplyMessage.send();
 
 	VariantArrayMessage authAckMessage( &socketDevice );
@@ -869,6 +1343,12 @@ void VeyonVncConnection::handleSecTypeVeyon( rfbClient *client )
 			challengeResponseMessage.write( VeyonCore::instance()->userRole() );
 			challengeResponseMessage.write( signature );
 			challengeResponseMessage.send();
+
+			if( requestResumptionTicket )
+			{
+				// ticket secret is chosen by the server and encrypted with our public key
+				t->receiveResumptionTicket( &socketDevice, QByteArray() );
+			}
 		}
 		break;
 
@@ -899,7 +1379,21 @@ void VeyonVncConnection::handleSecTypeVeyon( rfbClient *client )
 
 		VariantArrayMessage passwordResponse( &socketDevice );
 		passwordResponse.write( encryptedPassword.toByteArray() );
+
+		// choose the secret of the resumption ticket ourselves and pass it the same way as the password
+		QByteArray ticketSecret;
+		if( requestResumptionTicket )
+		{
+			ticketSecret = CryptoCore::generateChallenge().left( ResumptionTicketSecretSize );
+			passwordResponse.write( publicKey.encrypt( ticketSecret, CryptoCore::DefaultEncryptionAlgorithm ).toByteArray() );
+		}
+
 		passwordResponse.send();
+
+		if( requestResumptionTicket )
+		{
+			t->receiveResumptionTicket( &socketDevice, ticketSecret );
+		}
 		break;
 	}
 
@@ -911,6 +1405,31 @@ void VeyonVncConnection::handleSecTypeVeyon( rfbClient *client )
 		break;
 	}
 
+	case RfbVeyonAuth::Ticket:
+	{
+		VariantArrayMessage challengeReceiveMessage( &socketDevice );
+		challengeReceiveMessage.receive();
+		const auto challenge = challengeReceiveMessage.read().toByteArray();
+
+		if( challenge.size() != CryptoCore::ChallengeSize )
+		{
+			qCritical( "VeyonVncConnection::handleSecTypeVeyon(): challenge size mismatch!" );
+			break;
+		}
+
+		// prove possession of the ticket secret without disclosing it
+		VariantArrayMessage ticketAuthMessage( &socketDevice );
+		ticketAuthMessage.write( t->m_resumptionTicket );
+		ticketAuthMessage.write( QMessageAuthenticationCode::hash( challenge, t->m_resumptionTicketSecret,
+																   QCryptographicHash::Sha256 ) );
+		ticketAuthMessage.send();
+
+		// the server accepts each ticket only once
+		t->m_resumptionTicket.clear();
+		t->m_resumptionTicketSecret.clear();
+		break;
+	}
+
 	default:
 		// nothing to do - we just get accepted
 		break;
@@ -919,6 +1438,62 @@ void VeyonVncConnection::handleSecTypeVeyon( rfbClient *client )
 
 
 
+bool VeyonVncConnection::hasValidResumptionTicket() const
+{
+	return m_resumptionTicket.isEmpty() == false &&
+			m_resumptionTicketTimer.elapsed() < m_resumptionTicketLifetime * 1000 - ResumptionTicketExpiryMargin;
+}
+
+
+
+void VeyonVncConnection::receiveResumptionTicket( QIODevice* ioDevice, const QByteArray& secret )
+{
+	m_resumptionTicket.clear();
+	m_resumptionTicketSecret.clear();
+
+	// server only sends a ticket if authentication succeeded
+	VariantArrayMessage ticketMessage( ioDevice );
+	if( ticketMessage.receive() == false )
+	{
+		return;
+	}
+
+	const auto ticket = ticketMessage.read().toByteArray();
+	const auto lifetime = ticketMessage.read().toInt();
+	const auto encryptedSecret = ticketMessage.read().toByteArray();
+
+	auto ticketSecret = secret;
+
+	if( encryptedSecret.isEmpty() == false )
+	{
+		// secret was chosen by the server and encrypted with the public key of our role
+		auto key = VeyonCore::authenticationCredentials().privateKey();
+
+		CryptoCore::SecureArray decryptedSecret;
+		if( key.decrypt( CryptoCore::SecureArray( encryptedSecret ), &decryptedSecret,
+						 CryptoCore::DefaultEncryptionAlgorithm ) == false )
+		{
+			qWarning( "VeyonVncConnection::receiveResumptionTicket(): failed to decrypt ticket secret" );
+			return;
+		}
+
+		ticketSecret = decryptedSecret.toByteArray();
+	}
+
+	// server sends an empty ticket if it could not exchange a secret with us
+	if( ticket.isEmpty() || ticketSecret.isEmpty() )
+	{
+		return;
+	}
+
+	m_resumptionTicket = ticket;
+	m_resumptionTicketSecret = ticketSecret;
+	m_resumptionTicketLifetime = lifetime;
+	m_resumptionTicketTimer.restart();
+}
+
+
+
 void VeyonVncConnection::hookPrepareAuthentication(rfbClient *cl)
 {
 	VeyonVncConnection* t = (VeyonVncConnection *) rfbClientGetClientData( cl, nullptr );
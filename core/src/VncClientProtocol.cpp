@@ -24,7 +24,6 @@
 
 #include "VeyonCore.h"
 
-#include <QBuffer>
 #include <QRegion>
 #include <QTcpSocket>
 
@@ -73,7 +72,25 @@ VncClientProtocol::VncClientProtocol( QTcpSocket* socket, const QString& vncPass
 	m_vncPassword( vncPassword.toUtf8() ),
 	m_serverInitMessage(),
 	m_framebufferWidth( 0 ),
-	m_framebufferHeight( 0 )
+	m_framebufferHeight( 0 ),
+	m_lastMessage(),
+	m_lastUpdatedRect(),
+	m_lastMessageForwarded( false ),
+	m_lastCursorUpdateMessage(),
+	m_framebufferUpdateForwardingDevice( nullptr ),
+	m_updateState( UpdateMessageHeader ),
+	m_updateStateAfterPayload( UpdateRectFinished ),
+	m_updateMessage(),
+	m_updateRectsRemaining( 0 ),
+	m_updateRectHeader(),
+	m_updateRectOffset( 0 ),
+	m_updatePayloadRemaining( 0 ),
+	m_hextileX( 0 ),
+	m_hextileY( 0 ),
+	m_hextileSubencoding( 0 ),
+	m_updatedRegion(),
+	m_cursorUpdateRects(),
+	m_cursorUpdateRectCount( 0 )
 {
 	memset( &m_pixelFormat, 0, sz_rfbPixelFormat );
 }
@@ -83,6 +100,8 @@ VncClientProtocol::VncClientProtocol( QTcpSocket* socket, const QString& vncPass
 void VncClientProtocol::start()
 {
 	m_state = Protocol;
+
+	resetFramebufferUpdate();
 }
 
 
@@ -127,6 +146,9 @@ bool VncClientProtocol::setPixelFormat( rfbPixelFormat pixelFormat )
 	spf.format.greenMax = qFromBigEndian(pixelFormat.greenMax);
 	spf.format.blueMax = qFromBigEndian(pixelFormat.blueMax);
 
+	// rects of subsequent framebuffer updates are encoded in new format
+	m_pixelFormat = pixelFormat;
+
 	return m_socket->write( (const char *) &spf, sz_rfbSetPixelFormatMsg ) == sz_rfbSetPixelFormatMsg;
 }
 
@@ -185,6 +207,12 @@ void VncClientProtocol::requestFramebufferUpdate( bool incremental )
 
 bool VncClientProtocol::receiveMessage()
 {
+	// continue with partially received framebuffer update
+	if( m_updateState != UpdateMessageHeader )
+	{
+		return receiveFramebufferUpdateMessage();
+	}
+
 	uint8_t messageType = 0;
 	if( m_socket->peek( (char *) &messageType, sizeof(messageType) ) != sizeof(messageType) )
 	{
@@ -393,58 +421,152 @@ bool VncClientProtocol::receiveServerInitMessage()
 
 bool VncClientProtocol::receiveFramebufferUpdateMessage()
 {
-	// peek all available data and work on a local buffer so we can continously read from it
-	QByteArray data = m_socket->peek( m_socket->bytesAvailable() );
-
-	QBuffer buffer( &data );
-	buffer.open( QBuffer::ReadOnly );
+	const int bytesPerPixel = m_pixelFormat.bitsPerPixel / 8;
 
-	rfbFramebufferUpdateMsg message;
-	if( buffer.read( (char *) &message, sz_rfbFramebufferUpdateMsg ) != sz_rfbFramebufferUpdateMsg )
+	// process as much of the update as has arrived so far and resume at the
+	// same position as soon as more data is available
+	while( true )
 	{
-		return false;
-	}
+		switch( m_updateState )
+		{
+		case UpdateMessageHeader:
+		{
+			rfbFramebufferUpdateMsg message;
+			if( readUpdateData( &message, sz_rfbFramebufferUpdateMsg ) == false )
+			{
+				return false;
+			}
 
-	QRegion updatedRegion;
+			m_updatedRegion = QRegion();
+			m_updateRectsRemaining = qFromBigEndian( message.nRects );
 
-	int nRects = qFromBigEndian( message.nRects );
+			if( m_updateRectsRemaining == 0 )
+			{
+				return finishFramebufferUpdate();
+			}
 
-	for( int i = 0; i < nRects; ++i )
-	{
-		rfbFramebufferUpdateRectHeader rectHeader;
-		if( buffer.read( (char *) &rectHeader, sz_rfbFramebufferUpdateRectHeader ) != sz_rfbFramebufferUpdateRectHeader )
-		{
-			return false;
+			m_updateState = UpdateRectHeader;
+			break;
 		}
 
-		rectHeader.encoding = qFromBigEndian( rectHeader.encoding );
-		rectHeader.r.w = qFromBigEndian( rectHeader.r.w );
-		rectHeader.r.h = qFromBigEndian( rectHeader.r.h );
-		rectHeader.r.x = qFromBigEndian( rectHeader.r.x );
-		rectHeader.r.y = qFromBigEndian( rectHeader.r.y );
+		case UpdateRectHeader:
+			if( readUpdateData( &m_updateRectHeader, sz_rfbFramebufferUpdateRectHeader ) == false )
+			{
+				return false;
+			}
+
+			m_updateRectOffset = m_updateMessage.size() - sz_rfbFramebufferUpdateRectHeader;
+
+			m_updateRectHeader.encoding = qFromBigEndian( m_updateRectHeader.encoding );
+			m_updateRectHeader.r.w = qFromBigEndian( m_updateRectHeader.r.w );
+			m_updateRectHeader.r.h = qFromBigEndian( m_updateRectHeader.r.h );
+			m_updateRectHeader.r.x = qFromBigEndian( m_updateRectHeader.r.x );
+			m_updateRectHeader.r.y = qFromBigEndian( m_updateRectHeader.r.y );
+
+			if( m_updateRectHeader.encoding == rfbEncodingLastRect )
+			{
+				return finishFramebufferUpdate();
+			}
+
+			if( m_updateRectHeader.encoding == rfbEncodingNewFBSize )
+			{
+				m_framebufferWidth = m_updateRectHeader.r.w;
+				m_framebufferHeight = m_updateRectHeader.r.h;
+			}
+
+			if( beginRect() == false )
+			{
+				return false;
+			}
+			break;
+
+		case UpdateRectPayload:
+			if( readUpdatePayload() == false )
+			{
+				return false;
+			}
+			break;
+
+		case UpdateRectFinished:
+			if( finishRect() )
+			{
+				return finishFramebufferUpdate();
+			}
+			break;
 
-		if( rectHeader.encoding == rfbEncodingLastRect )
+		case UpdateRREHeader:
+		case UpdateCoRREHeader:
 		{
+			rfbRREHeader header;
+			if( readUpdateData( &header, sz_rfbRREHeader ) == false )
+			{
+				return false;
+			}
+
+			const int subrectSize = bytesPerPixel + ( m_updateState == UpdateRREHeader ? sz_rfbRectangle : 4 );
+
+			expectUpdatePayload( bytesPerPixel + static_cast<qint64>( qFromBigEndian( header.nSubrects ) ) * subrectSize,
+								 UpdateRectFinished );
 			break;
 		}
 
-		if( handleRect( buffer, rectHeader ) == false )
+		case UpdateZlibHeader:
 		{
-			return false;
+			rfbZlibHeader header;
+			if( readUpdateData( &header, sz_rfbZlibHeader ) == false )
+			{
+				return false;
+			}
+
+			expectUpdatePayload( qFromBigEndian( header.nBytes ), UpdateRectFinished );
+			break;
 		}
 
-		if( isPseudoEncoding( rectHeader ) == false &&
-			rectHeader.r.x+rectHeader.r.w <= m_framebufferWidth &&
-			rectHeader.r.y+rectHeader.r.h <= m_framebufferHeight )
+		case UpdateZRLEHeader:
 		{
-			updatedRegion += QRect( rectHeader.r.x, rectHeader.r.y, rectHeader.r.w, rectHeader.r.h );
+			rfbZRLEHeader header;
+			if( readUpdateData( &header, sz_rfbZRLEHeader ) == false )
+			{
+				return false;
+			}
+
+			expectUpdatePayload( qFromBigEndian( header.length ), UpdateRectFinished );
+			break;
 		}
-	}
 
-	m_lastUpdatedRect = updatedRegion.boundingRect();
+		case UpdateHextileTileHeader:
+			if( m_hextileY >= m_updateRectHeader.r.y + m_updateRectHeader.r.h ||
+					m_updateRectHeader.r.w == 0 )
+			{
+				m_updateState = UpdateRectFinished;
+				break;
+			}
+
+			if( readUpdateData( &m_hextileSubencoding, 1 ) == false )
+			{
+				return false;
+			}
 
-	// save as much data as we read by processing rects
-	return readMessage( buffer.pos() );
+			beginHextileTile();
+			break;
+
+		case UpdateHextileSubrectCount:
+		{
+			uint8_t subrectCount = 0;
+			if( readUpdateData( &subrectCount, 1 ) == false )
+			{
+				return false;
+			}
+
+			const int subrectSize = ( m_hextileSubencoding & rfbHextileSubrectsColoured ) ? 2 + bytesPerPixel : 2;
+
+			expectUpdatePayload( subrectCount * subrectSize, UpdateHextileTileHeader );
+			break;
+		}
+		}
+	}
+
+	return false;
 }
 
 
@@ -517,6 +639,7 @@ bool VncClientProtocol::readMessage( qint64 size )
 	if( message.size() == size )
 	{
 		m_lastMessage = message;
+		m_lastMessageForwarded = false;
 		return true;
 	}
 
@@ -527,69 +650,78 @@ bool VncClientProtocol::readMessage( qint64 size )
 
 
 
-bool VncClientProtocol::handleRect( QBuffer& buffer, const rfbFramebufferUpdateRectHeader& rectHeader )
+bool VncClientProtocol::beginRect()
 {
-	const int width = rectHeader.r.w;
-	const int height = rectHeader.r.h;
+	const int width = m_updateRectHeader.r.w;
+	const int height = m_updateRectHeader.r.h;
 
-	const int bytesPerPixel = m_pixelFormat.bitsPerPixel / 8;
-	const int bytesPerRow = ( width + 7 ) / 8;
+	const qint64 bytesPerPixel = m_pixelFormat.bitsPerPixel / 8;
+	const qint64 bytesPerRow = ( width + 7 ) / 8;
+	const qint64 pixelCount = static_cast<qint64>( width ) * height;
 
-	switch( rectHeader.encoding )
+	switch( m_updateRectHeader.encoding )
 	{
-	case rfbEncodingLastRect:
-		return true;
-
 	case rfbEncodingXCursor:
-		return width * height == 0 ||
-				( buffer.read( sz_rfbXCursorColors ).size() == sz_rfbXCursorColors &&
-				  buffer.read( 2 * bytesPerRow * height ).size() == 2 * bytesPerRow * height );
+		expectUpdatePayload( pixelCount == 0 ? 0 : sz_rfbXCursorColors + 2 * bytesPerRow * height, UpdateRectFinished );
+		return true;
 
 	case rfbEncodingRichCursor:
-		return width * height == 0 ||
-				( buffer.read( width * height * bytesPerPixel ).size() == width * height * bytesPerPixel &&
-				  buffer.read( bytesPerRow * height ).size() == bytesPerRow * height );
+		expectUpdatePayload( pixelCount * bytesPerPixel + bytesPerRow * height, UpdateRectFinished );
+		return true;
 
 	case rfbEncodingSupportedMessages:
-		return buffer.read( sz_rfbSupportedMessages ).size() == sz_rfbSupportedMessages;
+		expectUpdatePayload( sz_rfbSupportedMessages, UpdateRectFinished );
+		return true;
 
 	case rfbEncodingSupportedEncodings:
 	case rfbEncodingServerIdentity:
 		// width = byte count
-		return buffer.read( width ).size() == width;
+		expectUpdatePayload( width, UpdateRectFinished );
+		return true;
 
 	case rfbEncodingRaw:
-		return buffer.read( width * height * bytesPerPixel ).size() == width * height * bytesPerPixel;
+		expectUpdatePayload( pixelCount * bytesPerPixel, UpdateRectFinished );
+		return true;
 
 	case rfbEncodingCopyRect:
-		return buffer.read( sz_rfbCopyRect ).size() == sz_rfbCopyRect;
+		expectUpdatePayload( sz_rfbCopyRect, UpdateRectFinished );
+		return true;
 
 	case rfbEncodingRRE:
-		return handleRectEncodingRRE( buffer, bytesPerPixel );
+		m_updateState = UpdateRREHeader;
+		return true;
 
 	case rfbEncodingCoRRE:
-		return handleRectEncodingCoRRE( buffer, bytesPerPixel );
+		m_updateState = UpdateCoRREHeader;
+		return true;
 
 	case rfbEncodingHextile:
-		return handleRectEncodingHextile( buffer, rectHeader, bytesPerPixel );
+		m_hextileX = m_updateRectHeader.r.x;
+		m_hextileY = m_updateRectHeader.r.y;
+		m_updateState = UpdateHextileTileHeader;
+		return true;
 
 	case rfbEncodingUltra:
 	case rfbEncodingUltraZip:
 	case rfbEncodingZlib:
-		return handleRectEncodingZlib( buffer );
+		m_updateState = UpdateZlibHeader;
+		return true;
 
 	case rfbEncodingZRLE:
 	case rfbEncodingZYWRLE:
-		return handleRectEncodingZRLE( buffer );
+		m_updateState = UpdateZRLEHeader;
+		return true;
 
 	case rfbEncodingPointerPos:
 	case rfbEncodingKeyboardLedState:
 	case rfbEncodingNewFBSize:
 		// no further data to read for this rect
+		m_updateState = UpdateRectFinished;
 		return true;
 
 	default:
-		qCritical() << Q_FUNC_INFO << "Unsupported rect encoding" << rectHeader.encoding;
+		qCritical() << Q_FUNC_INFO << "Unsupported rect encoding" << m_updateRectHeader.encoding;
+		resetFramebufferUpdate();
 		m_socket->close();
 		break;
 	}
@@ -599,151 +731,187 @@ bool VncClientProtocol::handleRect( QBuffer& buffer, const rfbFramebufferUpdateR
 
 
 
-bool VncClientProtocol::handleRectEncodingRRE( QBuffer& buffer, int bytesPerPixel )
+void VncClientProtocol::beginHextileTile()
 {
-	rfbRREHeader hdr;
+	const int bytesPerPixel = m_pixelFormat.bitsPerPixel / 8;
+
+	const int rectRight = m_updateRectHeader.r.x + m_updateRectHeader.r.w;
+	const int rectBottom = m_updateRectHeader.r.y + m_updateRectHeader.r.h;
+
+	const int w = qMin( 16, rectRight - m_hextileX );
+	const int h = qMin( 16, rectBottom - m_hextileY );
 
-	if( buffer.read( (char *) &hdr, sz_rfbRREHeader ) != sz_rfbRREHeader )
+	// advance to next tile so we only have to track remaining data of the current one
+	m_hextileX += 16;
+	if( m_hextileX >= rectRight )
 	{
-		return false;
+		m_hextileX = m_updateRectHeader.r.x;
+		m_hextileY += 16;
 	}
 
-	const int rectDataSize =
-			qFromBigEndian( hdr.nSubrects ) * ( bytesPerPixel + sz_rfbRectangle );
+	if( m_hextileSubencoding & rfbHextileRaw )
+	{
+		expectUpdatePayload( w * h * bytesPerPixel, UpdateHextileTileHeader );
+		return;
+	}
 
-	return buffer.read( bytesPerPixel + rectDataSize ).size() == bytesPerPixel + rectDataSize;
+	int colorDataSize = 0;
+
+	if( m_hextileSubencoding & rfbHextileBackgroundSpecified )
+	{
+		colorDataSize += bytesPerPixel;
+	}
+
+	if( m_hextileSubencoding & rfbHextileForegroundSpecified )
+	{
+		colorDataSize += bytesPerPixel;
+	}
+
+	expectUpdatePayload( colorDataSize, ( m_hextileSubencoding & rfbHextileAnySubrects ) ?
+							 UpdateHextileSubrectCount : UpdateHextileTileHeader );
 }
 
 
 
-bool VncClientProtocol::handleRectEncodingCoRRE( QBuffer& buffer, int bytesPerPixel )
+bool VncClientProtocol::finishRect()
 {
-	rfbRREHeader hdr;
+	const auto& r = m_updateRectHeader.r;
 
-	if( buffer.read( (char *) &hdr, sz_rfbRREHeader ) != sz_rfbRREHeader )
+	if( isPseudoEncoding( m_updateRectHeader ) == false &&
+		r.x+r.w <= m_framebufferWidth &&
+		r.y+r.h <= m_framebufferHeight )
 	{
-		return false;
+		m_updatedRegion += QRect( r.x, r.y, r.w, r.h );
 	}
 
-	const int rectDataSize =
-			qFromBigEndian( hdr.nSubrects ) * ( bytesPerPixel + 4 );
+	if( isCursorEncoding( m_updateRectHeader ) )
+	{
+		m_cursorUpdateRects.append( m_updateMessage.constData() + m_updateRectOffset,
+									m_updateMessage.size() - m_updateRectOffset );
+		++m_cursorUpdateRectCount;
+	}
 
-	return buffer.read( bytesPerPixel + rectDataSize ).size() == bytesPerPixel + rectDataSize;
+	m_updateState = UpdateRectHeader;
 
+	return --m_updateRectsRemaining <= 0;
 }
 
 
 
-bool VncClientProtocol::handleRectEncodingHextile( QBuffer& buffer,
-													const rfbFramebufferUpdateRectHeader rectHeader,
-													int bytesPerPixel )
+bool VncClientProtocol::finishFramebufferUpdate()
 {
-	const int rx = rectHeader.r.x;
-	const int ry = rectHeader.r.y;
-	const int rw = rectHeader.r.w;
-	const int rh = rectHeader.r.h;
+	m_lastUpdatedRect = m_updatedRegion.boundingRect();
 
-	for( int y = ry; y < ry+rh; y += 16 )
+	m_lastCursorUpdateMessage.clear();
+	if( m_cursorUpdateRectCount > 0 )
 	{
-		for( int x = rx; x < rx+rw; x += 16 )
-		{
-			int w = 16, h = 16;
-			if( rx+rw - x < 16 ) w = rx+rw - x;
-			if( ry+rh - y < 16 ) h = ry+rh - y;
+		rfbFramebufferUpdateMsg message;
+		message.type = rfbFramebufferUpdate;
+		message.pad = 0;
+		message.nRects = qToBigEndian<uint16_t>( m_cursorUpdateRectCount );
 
-			uint8_t subEncoding = 0;
-			if( buffer.read( (char *) &subEncoding, 1 ) != 1 )
-			{
-				return false;
-			}
+		m_lastCursorUpdateMessage.append( reinterpret_cast<const char *>( &message ), sz_rfbFramebufferUpdateMsg );
+		m_lastCursorUpdateMessage.append( m_cursorUpdateRects );
+	}
 
-			if( subEncoding & rfbHextileRaw )
-			{
-				if( buffer.read( w * h * bytesPerPixel ).size() != w * h * bytesPerPixel )
-				{
-					return false;
-				}
-				continue;
-			}
+	if( m_framebufferUpdateForwardingDevice )
+	{
+		// pass update through in one piece so no other message written to the
+		// device can end up in the middle of it
+		if( m_framebufferUpdateForwardingDevice->write( m_updateMessage ) != m_updateMessage.size() )
+		{
+			qWarning( "VncClientProtocol::finishFramebufferUpdate(): could not forward framebuffer update" );
+		}
 
-			if( subEncoding & rfbHextileBackgroundSpecified )
-			{
-				if( buffer.read( bytesPerPixel ).size() != bytesPerPixel )
-				{
-					return false;
-				}
-			}
+		// only keep message header and reuse the buffer for the next update
+		// instead of allocating it again for every update
+		m_lastMessage = m_updateMessage.left( sz_rfbFramebufferUpdateMsg );
+		m_updateMessage.reserve( m_updateMessage.size() );
+		m_lastMessageForwarded = true;
+	}
+	else
+	{
+		m_lastMessage.swap( m_updateMessage );
+		m_lastMessageForwarded = false;
+	}
 
-			if( subEncoding & rfbHextileForegroundSpecified )
-			{
-				if( buffer.read( bytesPerPixel ).size() != bytesPerPixel )
-				{
-					return false;
-				}
-			}
+	resetFramebufferUpdate();
 
-			if( !( subEncoding & rfbHextileAnySubrects ) )
-			{
-				continue;
-			}
+	return true;
+}
 
-			uint8_t nSubrects = 0;
-			if( buffer.read( (char *) &nSubrects, 1 ) != 1 )
-			{
-				return false;
-			}
 
-			int64_t subRectDataSize = 0;
 
-			if( subEncoding & rfbHextileSubrectsColoured )
-			{
-				subRectDataSize = nSubrects * ( 2 + bytesPerPixel );
-			}
-			else
-			{
-				subRectDataSize = nSubrects * 2;
-			}
+bool VncClientProtocol::readUpdateData( void* data, qint64 size )
+{
+	if( m_socket->bytesAvailable() < size )
+	{
+		return false;
+	}
 
-			if( buffer.read( subRectDataSize ).size() != subRectDataSize )
-			{
-				return false;
-			}
-		}
+	const auto offset = m_updateMessage.size();
+	m_updateMessage.resize( offset + size );
+
+	if( m_socket->read( m_updateMessage.data() + offset, size ) != size )
+	{
+		qWarning( "VncClientProtocol::readUpdateData(): could not read %d bytes", (int) size );
+		m_updateMessage.resize( offset );
+		return false;
 	}
 
+	memcpy( data, m_updateMessage.constData() + offset, size );
+
 	return true;
 }
 
 
 
-bool VncClientProtocol::handleRectEncodingZlib( QBuffer& buffer )
+bool VncClientProtocol::readUpdatePayload()
 {
-	rfbZlibHeader hdr;
+	// consume whatever has arrived instead of waiting for the complete payload
+	const auto size = qMin( m_socket->bytesAvailable(), m_updatePayloadRemaining );
+
+	if( size > 0 )
+	{
+		const auto offset = m_updateMessage.size();
+		m_updateMessage.resize( offset + size );
+
+		const auto bytesRead = m_socket->read( m_updateMessage.data() + offset, size );
+		m_updateMessage.resize( offset + qMax<qint64>( 0, bytesRead ) );
+
+		m_updatePayloadRemaining -= qMax<qint64>( 0, bytesRead );
+	}
 
-	if( buffer.read( (char *) &hdr, sz_rfbZlibHeader ) != sz_rfbZlibHeader )
+	if( m_updatePayloadRemaining > 0 )
 	{
 		return false;
 	}
 
-	const auto n = qFromBigEndian( hdr.nBytes );
+	m_updateState = m_updateStateAfterPayload;
 
-	return buffer.read( n ).size() == static_cast<int64_t>( n );
+	return true;
 }
 
 
 
-bool VncClientProtocol::handleRectEncodingZRLE(QBuffer &buffer)
+void VncClientProtocol::expectUpdatePayload( qint64 size, FramebufferUpdateState nextState )
 {
-	rfbZRLEHeader hdr;
+	m_updatePayloadRemaining = size;
+	m_updateStateAfterPayload = nextState;
+	m_updateState = UpdateRectPayload;
+}
 
-	if( buffer.read( (char *) &hdr, sz_rfbZRLEHeader ) != sz_rfbZRLEHeader )
-	{
-		return false;
-	}
 
-	const auto n = qFromBigEndian( hdr.length );
 
-	return buffer.read( n ).size() == static_cast<int64_t>( n );
+void VncClientProtocol::resetFramebufferUpdate()
+{
+	m_updateState = UpdateMessageHeader;
+	m_updateMessage.resize( 0 );
+	m_updateRectsRemaining = 0;
+	m_updatePayloadRemaining = 0;
+	m_updatedRegion = QRegion();
+	m_cursorUpdateRects.resize( 0 );
+	m_cursorUpdateRectCount = 0;
 }
 
 
@@ -765,3 +933,20 @@ bool VncClientProtocol::isPseudoEncoding( const rfbFramebufferUpdateRectHeader&
 
 	return false;
 }
+
+
+
+bool VncClientProtocol::isCursorEncoding( const rfbFramebufferUpdateRectHeader& header )
+{
+	switch( header.encoding )
+	{
+	case rfbEncodingXCursor:
+	case rfbEncodingRichCursor:
+	case rfbEncodingPointerPos:
+		return true;
+	default:
+		break;
+	}
+
+	return false;
+}
@@ -0,0 +1,960 @@
+/*
+ * VncConnectionPool.cpp - implementation of VncConnectionPool class
+ *
+ * Copyright (c) 2017 Tobias Junghans <tobydox@users.sf.net>
+ *
+ * This file is part of Veyon - http://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include <QMutexLocker>
+#include <QRunnable>
+
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "VeyonVncConnection.h"
+#include "VncConnectionPool.h"
+
+extern "C"
+{
+	#include <rfb/rfbclient.h>
+}
+
+
+class VncConnectAttempt : public QRunnable
+{
+public:
+	VncConnectAttempt( VncConnectionPoolWorker* worker, VeyonVncConnection* connection ) :
+		QRunnable(),
+		m_worker( worker ),
+		m_connection( connection )
+	{
+	}
+
+	void run() override
+	{
+		m_worker->performConnectAttempt( m_connection );
+	}
+
+private:
+	VncConnectionPoolWorker* m_worker;
+	VeyonVncConnection* m_connection;
+
+} ;
+
+
+
+class VncMessageHandler : public QRunnable
+{
+public:
+	VncMessageHandler( VncConnectionPoolWorker* worker, VeyonVncConnection* connection ) :
+		QRunnable(),
+		m_worker( worker ),
+		m_connection( connection )
+	{
+	}
+
+	void run() override
+	{
+		m_worker->performMessageHandling( m_connection );
+	}
+
+private:
+	VncConnectionPoolWorker* m_worker;
+	VeyonVncConnection* m_connection;
+
+} ;
+
+
+
+VncConnectionPool::VncConnectionPool( int workerCount, QObject* parent ) :
+	QObject( parent ),
+	m_connectThreadPool(),
+	m_messageThreadPool(),
+	m_workers(),
+	m_nextWorker( 0 ),
+	m_connectionsLock(),
+	m_connectionRemovedCondition(),
+	m_connections()
+{
+	if( workerCount <= 0 )
+	{
+		workerCount = qMax( 1, QThread::idealThreadCount() );
+	}
+
+	m_connectThreadPool.setMaxThreadCount( MaximumConcurrentConnectAttempts );
+	m_messageThreadPool.setMaxThreadCount( MaximumConcurrentMessageHandlers );
+
+	if( isSupported() == false )
+	{
+		return;
+	}
+
+	for( int i = 0; i < workerCount; ++i )
+	{
+		auto worker = new VncConnectionPoolWorker( this, &m_connectThreadPool, &m_messageThreadPool );
+		if( worker->isValid() )
+		{
+			worker->start();
+			m_workers.append( worker );
+		}
+		else
+		{
+			qCritical( "VncConnectionPool: could not initialize worker" );
+			delete worker;
+		}
+	}
+
+	qDebug() << "VncConnectionPool: started" << m_workers.count() << "workers";
+}
+
+
+
+VncConnectionPool::~VncConnectionPool()
+{
+	// do not start new connection attempts and wait for pending ones
+	for( auto worker : qAsConst( m_workers ) )
+	{
+		worker->prepareShutdown();
+	}
+
+	m_connectThreadPool.waitForDone();
+
+	// close all remaining connections - workers interrupt and wait for their message handlers
+	for( auto worker : qAsConst( m_workers ) )
+	{
+		worker->shutdown();
+		delete worker;
+	}
+
+	m_messageThreadPool.waitForDone();
+
+	m_workers.clear();
+}
+
+
+
+bool VncConnectionPool::isSupported()
+{
+#ifdef Q_OS_LINUX
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+
+bool VncConnectionPool::addConnection( VeyonVncConnection* connection )
+{
+	QMutexLocker locker( &m_connectionsLock );
+
+	if( m_workers.isEmpty() )
+	{
+		return false;
+	}
+
+	auto worker = m_connections.value( connection );
+	if( worker == nullptr )
+	{
+		worker = m_workers[m_nextWorker];
+		m_nextWorker = ( m_nextWorker + 1 ) % m_workers.count();
+
+		m_connections[connection] = worker;
+	}
+
+	connection->m_attachedToPool.storeRelease( 1 );
+
+	worker->addConnection( connection );
+
+	return true;
+}
+
+
+
+void VncConnectionPool::removeConnection( VeyonVncConnection* connection, bool deleteAfterRemoval, bool waitForRemoval )
+{
+	QMutexLocker locker( &m_connectionsLock );
+
+	auto worker = m_connections.value( connection );
+	if( worker == nullptr )
+	{
+		return;
+	}
+
+	worker->removeConnection( connection, deleteAfterRemoval );
+
+	if( waitForRemoval )
+	{
+		while( m_connections.contains( connection ) )
+		{
+			m_connectionRemovedCondition.wait( &m_connectionsLock );
+		}
+	}
+}
+
+
+
+void VncConnectionPool::wakeUp( VeyonVncConnection* connection )
+{
+	auto worker = workerOf( connection );
+	if( worker )
+	{
+		worker->wakeUp( connection );
+	}
+}
+
+
+
+void VncConnectionPool::reschedule( VeyonVncConnection* connection )
+{
+	auto worker = workerOf( connection );
+	if( worker )
+	{
+		worker->reschedule( connection );
+	}
+}
+
+
+
+void VncConnectionPool::retryNow( VeyonVncConnection* connection )
+{
+	auto worker = workerOf( connection );
+	if( worker )
+	{
+		worker->retryNow( connection );
+	}
+}
+
+
+
+int VncConnectionPool::connectionCount() const
+{
+	QMutexLocker locker( &m_connectionsLock );
+
+	return m_connections.count();
+}
+
+
+
+VncConnectionPoolWorker* VncConnectionPool::workerOf( VeyonVncConnection* connection ) const
+{
+	QMutexLocker locker( &m_connectionsLock );
+
+	return m_connections.value( connection );
+}
+
+
+
+void VncConnectionPool::connectionAdded( VeyonVncConnection* connection, VncConnectionPoolWorker* worker )
+{
+	QMutexLocker locker( &m_connectionsLock );
+
+	m_connections[connection] = worker;
+
+	connection->m_attachedToPool.storeRelease( 1 );
+}
+
+
+
+void VncConnectionPool::connectionRemoved( VeyonVncConnection* connection )
+{
+	QMutexLocker locker( &m_connectionsLock );
+
+	connection->m_attachedToPool.storeRelease( 0 );
+
+	m_connections.remove( connection );
+
+	m_connectionRemovedCondition.wakeAll();
+}
+
+
+
+
+VncConnectionPoolWorker::VncConnectionPoolWorker( VncConnectionPool* pool, QThreadPool* connectThreadPool,
+												  QThreadPool* messageThreadPool ) :
+	QThread(),
+	m_pool( pool ),
+	m_connectThreadPool( connectThreadPool ),
+	m_messageThreadPool( messageThreadPool ),
+	m_epollFd( -1 ),
+	m_wakeUpFd( -1 ),
+	m_shutdownPrepared( false ),
+	m_shutdownRequested( false ),
+	m_commandLock(),
+	m_commands(),
+	m_entries(),
+	m_receivingCount( 0 ),
+	m_clock(),
+	m_processedTick( 0 ),
+	m_scheduledTimerCount( 0 ),
+	m_timerWheel( TimerWheelSlotCount )
+{
+	m_clock.start();
+
+#ifdef Q_OS_LINUX
+	m_epollFd = epoll_create1( EPOLL_CLOEXEC );
+	m_wakeUpFd = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+
+	if( isValid() )
+	{
+		// wake up events are identified by a null pointer
+		epoll_event event;
+		event.events = EPOLLIN;
+		event.data.ptr = nullptr;
+		epoll_ctl( m_epollFd, EPOLL_CTL_ADD, m_wakeUpFd, &event );
+	}
+#endif
+}
+
+
+
+VncConnectionPoolWorker::~VncConnectionPoolWorker()
+{
+#ifdef Q_OS_LINUX
+	if( m_wakeUpFd >= 0 )
+	{
+		close( m_wakeUpFd );
+	}
+
+	if( m_epollFd >= 0 )
+	{
+		close( m_epollFd );
+	}
+#endif
+}
+
+
+
+void VncConnectionPoolWorker::addConnection( VeyonVncConnection* connection )
+{
+	enqueueCommand( Command::Add, connection );
+}
+
+
+
+void VncConnectionPoolWorker::removeConnection( VeyonVncConnection* connection, bool deleteAfterRemoval )
+{
+	enqueueCommand( Command::Remove, connection, deleteAfterRemoval );
+}
+
+
+
+void VncConnectionPoolWorker::wakeUp( VeyonVncConnection* connection )
+{
+	enqueueCommand( Command::WakeUp, connection );
+}
+
+
+
+void VncConnectionPoolWorker::reschedule( VeyonVncConnection* connection )
+{
+	enqueueCommand( Command::Reschedule, connection );
+}
+
+
+
+void VncConnectionPoolWorker::retryNow( VeyonVncConnection* connection )
+{
+	enqueueCommand( Command::RetryNow, connection );
+}
+
+
+
+void VncConnectionPoolWorker::performConnectAttempt( VeyonVncConnection* connection )
+{
+	// runs in thread of connect thread pool
+	enqueueCommand( Command::ConnectFinished, connection, connection->tryConnect() );
+}
+
+
+
+void VncConnectionPoolWorker::performMessageHandling( VeyonVncConnection* connection )
+{
+	// runs in thread of message thread pool - libvncclient reads complete messages
+	// blocking so a host stalling in the middle of an update only holds up this thread
+	enqueueCommand( Command::MessagesHandled, connection, connection->handleServerMessages() );
+}
+
+
+
+void VncConnectionPoolWorker::prepareShutdown()
+{
+	// no connection attempts will be started afterwards
+	QMutexLocker locker( &m_commandLock );
+	m_shutdownPrepared = true;
+}
+
+
+
+void VncConnectionPoolWorker::shutdown()
+{
+	m_shutdownRequested = true;
+
+	signalWakeUp();
+
+	wait();
+}
+
+
+
+void VncConnectionPoolWorker::run()
+{
+#ifdef Q_OS_LINUX
+	epoll_event events[MaximumEventCount];
+
+	while( m_shutdownRequested == false )
+	{
+		const int eventCount = epoll_wait( m_epollFd, events, MaximumEventCount, nextTimerTimeout() );
+		if( eventCount < 0 && errno != EINTR )
+		{
+			qCritical() << "VncConnectionPoolWorker::run(): epoll_wait() failed with error" << errno;
+			break;
+		}
+
+		bool wokenUp = false;
+
+		for( int i = 0; i < eventCount; ++i )
+		{
+			auto entry = static_cast<Entry *>( events[i].data.ptr );
+			if( entry )
+			{
+				handleReadable( entry );
+			}
+			else
+			{
+				wokenUp = true;
+			}
+		}
+
+		// process commands after handling socket events as they may delete entries
+		if( wokenUp )
+		{
+			clearWakeUp();
+			processCommands();
+		}
+
+		processExpiredTimers();
+	}
+#endif
+
+	waitForMessageHandlers();
+
+	// process pending removals and results of finished connection attempts
+	processCommands();
+
+	const auto entries = m_entries.values();
+	for( auto entry : entries )
+	{
+		finishRemoval( entry );
+	}
+}
+
+
+
+void VncConnectionPoolWorker::enqueueCommand( Command::Types type, VeyonVncConnection* connection, bool flag )
+{
+	m_commandLock.lock();
+	m_commands.enqueue( { type, connection, flag } );
+	m_commandLock.unlock();
+
+	signalWakeUp();
+}
+
+
+
+void VncConnectionPoolWorker::processCommands()
+{
+	m_commandLock.lock();
+	QQueue<Command> commands;
+	commands.swap( m_commands );
+	m_commandLock.unlock();
+
+	for( const auto& command : qAsConst( commands ) )
+	{
+		auto entry = m_entries.value( command.connection );
+
+		switch( command.type )
+		{
+		case Command::Add:
+			if( entry )
+			{
+				// connection has been restarted before previous removal was processed
+				entry->removalRequested = false;
+				entry->deleteAfterRemoval = false;
+			}
+			else
+			{
+				entry = new Entry { command.connection, Entry::Idle, false, false, false, false, false, 0 };
+				m_entries[command.connection] = entry;
+				m_pool->connectionAdded( command.connection, this );
+				startConnecting( entry );
+			}
+			break;
+
+		case Command::Remove:
+			if( entry )
+			{
+				entry->removalRequested = true;
+				entry->deleteAfterRemoval |= command.flag;
+
+				// wait for running connection attempt or message handler to finish
+				if( entry->phase == Entry::Receiving )
+				{
+					interruptReceiving( entry );
+				}
+				else if( entry->phase != Entry::Connecting )
+				{
+					finishRemoval( entry );
+				}
+			}
+			break;
+
+		case Command::WakeUp:
+			if( entry && entry->phase == Entry::Connected )
+			{
+				entry->connection->sendEvents();
+			}
+			break;
+
+		case Command::Reschedule:
+			// apply changed update interval immediately instead of waiting for the current one to expire
+			if( entry && ( entry->phase == Entry::Connected || entry->phase == Entry::Receiving ) )
+			{
+				handleTimer( entry );
+			}
+			else if( entry && entry->phase == Entry::ConnectPending )
+			{
+				scheduleTimer( entry, entry->connection->retryInterval() );
+			}
+			break;
+
+		case Command::RetryNow:
+			// do not wait for the (possibly backed off) retry interval to expire
+			if( entry && entry->phase == Entry::ConnectPending )
+			{
+				cancelTimer( entry );
+				startConnecting( entry );
+			}
+			break;
+
+		case Command::ConnectFinished:
+			if( entry )
+			{
+				handleConnectFinished( entry, command.flag );
+			}
+			break;
+
+		case Command::MessagesHandled:
+			if( entry )
+			{
+				handleMessagesHandled( entry, command.flag );
+			}
+			break;
+		}
+	}
+}
+
+
+
+void VncConnectionPoolWorker::signalWakeUp()
+{
+#ifdef Q_OS_LINUX
+	const quint64 value = 1;
+	if( write( m_wakeUpFd, &value, sizeof(value) ) < 0 && errno != EAGAIN )
+	{
+		qWarning() << "VncConnectionPoolWorker::signalWakeUp(): write() failed with error" << errno;
+	}
+#endif
+}
+
+
+
+void VncConnectionPoolWorker::clearWakeUp()
+{
+#ifdef Q_OS_LINUX
+	quint64 value = 0;
+	if( read( m_wakeUpFd, &value, sizeof(value) ) < 0 && errno != EAGAIN )
+	{
+		qWarning() << "VncConnectionPoolWorker::clearWakeUp(): read() failed with error" << errno;
+	}
+#endif
+}
+
+
+
+void VncConnectionPoolWorker::startConnecting( Entry* entry )
+{
+	QMutexLocker locker( &m_commandLock );
+
+	if( m_shutdownPrepared )
+	{
+		entry->phase = Entry::Idle;
+		return;
+	}
+
+	if( entry->phase != Entry::ConnectPending )
+	{
+		entry->connection->setState( VeyonVncConnection::Connecting );
+	}
+
+	entry->phase = Entry::Connecting;
+
+	m_connectThreadPool->start( new VncConnectAttempt( this, entry->connection ) );
+}
+
+
+
+void VncConnectionPoolWorker::handleConnectFinished( Entry* entry, bool connected )
+{
+	entry->phase = connected ? Entry::Connected : Entry::Idle;
+
+	if( entry->removalRequested )
+	{
+		finishRemoval( entry );
+	}
+	else if( connected )
+	{
+		entry->connection->beginConnection();
+
+		// request initial framebuffer and start update interval
+		handleTimer( entry );
+	}
+	else
+	{
+		entry->phase = Entry::ConnectPending;
+		scheduleTimer( entry, entry->connection->retryInterval() );
+	}
+}
+
+
+
+void VncConnectionPoolWorker::handleTimer( Entry* entry )
+{
+	switch( entry->phase )
+	{
+	case Entry::ConnectPending:
+		startConnecting( entry );
+		break;
+
+	case Entry::Connected:
+		if( entry->connection->requestInitialFramebuffer() == false )
+		{
+			disconnectEntry( entry );
+			break;
+		}
+
+		entry->connection->requestPeriodicFullUpdate();
+		entry->connection->sendEvents();
+
+		// process incoming messages at most once per update interval
+		armSocket( entry );
+		scheduleTimer( entry, entry->connection->pollInterval() );
+		break;
+
+	case Entry::Receiving:
+		// connection must not be accessed while a message handler reads from it
+		entry->timerDeferred = true;
+		break;
+
+	default:
+		break;
+	}
+}
+
+
+
+void VncConnectionPoolWorker::handleReadable( Entry* entry )
+{
+	if( entry->phase != Entry::Connected )
+	{
+		return;
+	}
+
+	// socket is not armed again until the message handler has finished
+	entry->phase = Entry::Receiving;
+	++m_receivingCount;
+
+	m_messageThreadPool->start( new VncMessageHandler( this, entry->connection ) );
+}
+
+
+
+void VncConnectionPoolWorker::handleMessagesHandled( Entry* entry, bool success )
+{
+	if( entry->phase != Entry::Receiving )
+	{
+		return;
+	}
+
+	entry->phase = Entry::Connected;
+	--m_receivingCount;
+
+	if( entry->removalRequested )
+	{
+		finishRemoval( entry );
+	}
+	else if( success == false )
+	{
+		disconnectEntry( entry );
+	}
+	else if( entry->timerDeferred )
+	{
+		entry->timerDeferred = false;
+		handleTimer( entry );
+	}
+	else
+	{
+		// deliver input events queued meanwhile
+		entry->connection->sendEvents();
+
+		if( entry->connection->m_framebufferUpdateInterval <= 0 )
+		{
+			armSocket( entry );
+		}
+	}
+}
+
+
+
+void VncConnectionPoolWorker::interruptReceiving( Entry* entry )
+{
+#ifdef Q_OS_LINUX
+	// makes libvncclient's blocking read fail right away instead of waiting for a stalled host
+	::shutdown( entry->connection->m_cl->sock, SHUT_RDWR );
+#endif
+}
+
+
+
+void VncConnectionPoolWorker::waitForMessageHandlers()
+{
+	for( auto entry : qAsConst( m_entries ) )
+	{
+		if( entry->phase == Entry::Receiving )
+		{
+			interruptReceiving( entry );
+		}
+	}
+
+#ifdef Q_OS_LINUX
+	epoll_event event;
+
+	// results of message handlers are delivered as commands
+	while( m_receivingCount > 0 )
+	{
+		if( epoll_wait( m_epollFd, &event, 1, -1 ) > 0 && event.data.ptr == nullptr )
+		{
+			clearWakeUp();
+			processCommands();
+		}
+	}
+#endif
+}
+
+
+
+void VncConnectionPoolWorker::disconnectEntry( Entry* entry )
+{
+	unwatchSocket( entry );
+	cancelTimer( entry );
+
+	entry->connection->sendEvents();
+	entry->connection->closeConnection();
+
+	// reconnect after retry interval like after failed connection attempts
+	entry->phase = Entry::ConnectPending;
+	entry->timerDeferred = false;
+
+	scheduleTimer( entry, entry->connection->retryInterval() );
+}
+
+
+
+void VncConnectionPoolWorker::finishRemoval( Entry* entry )
+{
+	auto connection = entry->connection;
+
+	cancelTimer( entry );
+
+	if( entry->phase == Entry::Connected )
+	{
+		unwatchSocket( entry );
+
+		connection->sendEvents();
+		connection->closeConnection();
+	}
+	else
+	{
+		connection->setState( VeyonVncConnection::Disconnected );
+	}
+
+	const auto deleteAfterRemoval = entry->deleteAfterRemoval;
+
+	m_entries.remove( connection );
+	delete entry;
+
+	// detach before scheduling deletion so the connection does not defer its deletion to us again
+	m_pool->connectionRemoved( connection );
+
+	// connection object must not be accessed anymore afterwards as it might be destroyed
+	if( deleteAfterRemoval )
+	{
+		QMetaObject::invokeMethod( connection, "deleteLater", Qt::QueuedConnection );
+	}
+}
+
+
+
+void VncConnectionPoolWorker::armSocket( Entry* entry )
+{
+#ifdef Q_OS_LINUX
+	epoll_event event;
+	event.events = EPOLLIN | EPOLLONESHOT;
+	event.data.ptr = entry;
+
+	if( epoll_ctl( m_epollFd, entry->watched ? EPOLL_CTL_MOD : EPOLL_CTL_ADD,
+				   entry->connection->m_cl->sock, &event ) == 0 )
+	{
+		entry->watched = true;
+	}
+	else
+	{
+		qWarning() << "VncConnectionPoolWorker::armSocket(): epoll_ctl() failed with error" << errno;
+	}
+#endif
+}
+
+
+
+void VncConnectionPoolWorker::unwatchSocket( Entry* entry )
+{
+#ifdef Q_OS_LINUX
+	if( entry->watched )
+	{
+		epoll_event event;
+		epoll_ctl( m_epollFd, EPOLL_CTL_DEL, entry->connection->m_cl->sock, &event );
+		entry->watched = false;
+	}
+#endif
+}
+
+
+
+void VncConnectionPoolWorker::scheduleTimer( Entry* entry, int msecs )
+{
+	cancelTimer( entry );
+
+	const qint64 ticks = qMax<qint64>( 1, ( msecs + TimerWheelResolution - 1 ) / TimerWheelResolution );
+
+	entry->timerTick = qMax( currentTick(), m_processedTick ) + ticks;
+	entry->timerScheduled = true;
+
+	m_timerWheel[entry->timerTick % TimerWheelSlotCount].append( entry );
+	++m_scheduledTimerCount;
+}
+
+
+
+void VncConnectionPoolWorker::cancelTimer( Entry* entry )
+{
+	if( entry->timerScheduled )
+	{
+		m_timerWheel[entry->timerTick % TimerWheelSlotCount].removeOne( entry );
+		entry->timerScheduled = false;
+		--m_scheduledTimerCount;
+	}
+}
+
+
+
+void VncConnectionPoolWorker::processExpiredTimers()
+{
+	const qint64 now = currentTick();
+
+	if( m_scheduledTimerCount <= 0 || now <= m_processedTick )
+	{
+		m_processedTick = qMax( m_processedTick, now );
+		return;
+	}
+
+	QList<Entry *> expiredEntries;
+
+	// visit each slot at most once even if we fell behind more than one wheel revolution
+	for( qint64 tick = qMax( m_processedTick + 1, now - TimerWheelSlotCount + 1 ); tick <= now; ++tick )
+	{
+		auto& slot = m_timerWheel[tick % TimerWheelSlotCount];
+		for( auto it = slot.begin(); it != slot.end(); )
+		{
+			if( (*it)->timerTick <= now )
+			{
+				(*it)->timerScheduled = false;
+				--m_scheduledTimerCount;
+				expiredEntries.append( *it );
+				it = slot.erase( it );
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+
+	m_processedTick = now;
+
+	for( auto entry : qAsConst( expiredEntries ) )
+	{
+		handleTimer( entry );
+	}
+}
+
+
+
+int VncConnectionPoolWorker::nextTimerTimeout() const
+{
+	if( m_scheduledTimerCount <= 0 )
+	{
+		return -1;
+	}
+
+	const qint64 elapsed = m_clock.elapsed();
+
+	for( qint64 tick = m_processedTick + 1; tick <= m_processedTick + TimerWheelSlotCount; ++tick )
+	{
+		if( m_timerWheel[tick % TimerWheelSlotCount].isEmpty() == false )
+		{
+			// entries of this slot might belong to a later revolution in which case we simply wake up early
+			return static_cast<int>( qMax<qint64>( 0, tick * TimerWheelResolution - elapsed ) );
+		}
+	}
+
+	return TimerWheelSlotCount * TimerWheelResolution;
+}
+
+
+
+qint64 VncConnectionPoolWorker::currentTick() const
+{
+	return m_clock.elapsed() / TimerWheelResolution;
+}
@@ -228,8 +228,12 @@ bool VncServerProtocol::receiveAuthenticationTypeResponse()
 
 		const QString username = message.read().toString();
 
+		// clients supporting session resumption ask for a ticket (not sent by older clients)
+		const bool resumptionTicketRequested = message.read().toBool();
+
 		m_client->setAuthType( chosenAuthType );
 		m_client->setUsername( username );
+		m_client->setResumptionTicketRequested( resumptionTicketRequested );
 		m_client->setHostAddress( m_socket->peerAddress().toString() );
 
 		setState( Authenticating );
@@ -249,6 +253,21 @@ bool VncServerProtocol::receiveAuthenticationTypeResponse()
 
 bool VncServerProtocol::receiveAuthenticationMessage()
 {
+	// authentication might still be running or have been finished asynchronously
+	// (e.g. when verifying a signature in background)
+	switch( m_client->authState() )
+	{
+	case VncServerClient::AuthPending:
+		return false;
+
+	case VncServerClient::AuthFinishedSuccess:
+	case VncServerClient::AuthFinishedFail:
+		return finishAuthentication();
+
+	default:
+		break;
+	}
+
 	VariantArrayMessage message( m_socket );
 
 	if( message.isReadyForReceive() && message.receive() )
@@ -265,6 +284,13 @@ bool VncServerProtocol::processAuthentication( VariantArrayMessage& message )
 {
 	processAuthenticationMessage( message );
 
+	return finishAuthentication();
+}
+
+
+
+bool VncServerProtocol::finishAuthentication()
+{
 	switch( m_client->authState() )
 	{
 	case VncServerClient::AuthFinishedSuccess:
@@ -27,6 +27,7 @@
 #include "ComputerListModel.h"
 #include "ComputerManager.h"
 #include "FeatureManager.h"
+#include "ImageScaler.h"
 
 
 ComputerListModel::ComputerListModel( ComputerManager& manager,
@@ -218,7 +219,13 @@ QImage ComputerListModel::computerDecorationRole( const Computer& computer ) con
 		break;
 	}
 
-	return image.scaled( controlInterface.scaledScreenSize(), Qt::KeepAspectRatio );
+	const auto size = image.size().scaled( controlInterface.scaledScreenSize(), Qt::KeepAspectRatio );
+	if( ImageScaler::canScale( image, size ) )
+	{
+		return ImageScaler::scaled( image, size );
+	}
+
+	return image.scaled( size );
 }
 
 
@@ -32,6 +32,7 @@
 #include "BuiltinFeatures.h"
 #include "ComputerManager.h"
 #include "FeatureManager.h"
+#include "HostReachabilityProber.h"
 #include "VeyonConfiguration.h"
 #include "NetworkObject.h"
 #include "NetworkObjectDirectoryManager.h"
@@ -40,6 +41,7 @@
 #include "NetworkObjectTreeModel.h"
 #include "UserConfig.h"
 #include "UserSessionControl.h"
+#include "VncConnectionPool.h"
 
 
 ComputerManager::ComputerManager( UserConfig& config,
@@ -56,6 +58,8 @@ ComputerManager::ComputerManager( UserConfig& config,
 	m_networkObjectOverlayDataModel( new NetworkObjectOverlayDataModel( 1, Qt::DisplayRole, tr( "User" ), this ) ),
 	m_computerTreeModel( new CheckableItemProxyModel( NetworkObjectModel::UidRole, this ) ),
 	m_networkObjectFilterProxyModel( new NetworkObjectFilterProxyModel( this ) ),
+	m_connectionPool( nullptr ),
+	m_reachabilityProber( new HostReachabilityProber ),
 	m_localHostNames( QHostInfo::localHostName().toLower() ),
 	m_localHostAddresses( QHostInfo::fromName( QHostInfo::localHostName() ).addresses() )
 {
@@ -77,6 +81,11 @@ ComputerManager::ComputerManager( UserConfig& config,
 								 QHostInfo::localDomainName().toLower() );
 	}
 
+	if( VeyonCore::config().isConnectionPoolEnabled() && VncConnectionPool::isSupported() )
+	{
+		m_connectionPool = new VncConnectionPool( 0, this );
+	}
+
 	initNetworkObjectLayer();
 	initRooms();
 	initComputerTreeModel();
@@ -122,6 +131,28 @@ void ComputerManager::updateComputerScreenSize()
 
 
 
+void ComputerManager::updateComputerScreenVisibility( const QSet<int>& visibleComputerIndexes, bool monitoringViewVisible )
+{
+	int index = 0;
+
+	for( auto& computer : m_computerList )
+	{
+		auto updateMode = ComputerControlInterface::SuspendedUpdates;
+
+		if( monitoringViewVisible )
+		{
+			updateMode = visibleComputerIndexes.contains( index ) ? ComputerControlInterface::FullUpdates
+																  : ComputerControlInterface::ReducedUpdates;
+		}
+
+		computer.controlInterface().setUpdateMode( updateMode );
+
+		++index;
+	}
+}
+
+
+
 void ComputerManager::addRoom( const QString& room )
 {
 	m_roomFilterList.append( room );
@@ -503,7 +534,7 @@ QSize ComputerManager::computerScreenSize() const
 
 void ComputerManager::startComputerControlInterface( Computer& computer, int index )
 {
-	computer.controlInterface().start( computerScreenSize(), &m_builtinFeatures );
+	computer.controlInterface().start( computerScreenSize(), &m_builtinFeatures, m_connectionPool, m_reachabilityProber );
 
 	connect( &computer.controlInterface(), &ComputerControlInterface::featureMessageReceived,
 			 &m_featureManager, &FeatureManager::handleMasterFeatureMessage );
@@ -25,17 +25,22 @@
 #ifndef COMPUTER_MANAGER_H
 #define COMPUTER_MANAGER_H
 
+#include <QSet>
+#include <QSharedPointer>
+
 #include "Computer.h"
 #include "CheckableItemProxyModel.h"
 
 class QHostAddress;
 class BuiltinFeatures;
 class FeatureManager;
+class HostReachabilityProber;
 class NetworkObjectDirectory;
 class NetworkObjectDirectoryManager;
 class NetworkObjectFilterProxyModel;
 class NetworkObjectOverlayDataModel;
 class UserConfig;
+class VncConnectionPool;
 
 class ComputerManager : public QObject
 {
@@ -70,6 +75,7 @@ public:
 	ComputerControlInterfaceList computerControlInterfaces();
 
 	void updateComputerScreenSize();
+	void updateComputerScreenVisibility( const QSet<int>& visibleComputerIndexes, bool monitoringViewVisible );
 
 	void addRoom( const QString& room );
 	void removeRoom( const QString& room );
@@ -122,6 +128,8 @@ private:
 	NetworkObjectOverlayDataModel* m_networkObjectOverlayDataModel;
 	CheckableItemProxyModel* m_computerTreeModel;
 	NetworkObjectFilterProxyModel* m_networkObjectFilterProxyModel;
+	VncConnectionPool* m_connectionPool;
+	QSharedPointer<HostReachabilityProber> m_reachabilityProber;
 
 	QStringList m_currentRooms;
 	QStringList m_roomFilterList;
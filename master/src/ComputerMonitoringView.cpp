@@ -25,7 +25,6 @@
 #include <QMenu>
 #include <QScrollBar>
 #include <QShowEvent>
-#include <QTimer>
 
 #include "ComputerManager.h"
 #include "ComputerMonitoringView.h"
@@ -42,12 +41,30 @@ ComputerMonitoringView::ComputerMonitoringView( QWidget *parent ) :
 	m_masterCore( nullptr ),
 	m_featureMenu( new QMenu( this ) ),
 	m_computerListModel( nullptr ),
-	m_sortFilterProxyModel( this )
+	m_sortFilterProxyModel( this ),
+	m_visibilityUpdateTimer( this )
 {
 	ui->setupUi( this );
 
 	m_sortFilterProxyModel.setFilterCaseSensitivity( Qt::CaseInsensitive );
 
+	// collect changes of the visible area and report them at once
+	m_visibilityUpdateTimer.setSingleShot( true );
+	m_visibilityUpdateTimer.setInterval( VisibilityUpdateDelay );
+
+	connect( &m_visibilityUpdateTimer, &QTimer::timeout,
+			 this, &ComputerMonitoringView::updateComputerScreenVisibility );
+
+	const auto scheduleVisibilityUpdate = [this]() { m_visibilityUpdateTimer.start(); };
+
+	connect( ui->listView->verticalScrollBar(), &QScrollBar::valueChanged, this, scheduleVisibilityUpdate );
+	connect( ui->listView->horizontalScrollBar(), &QScrollBar::valueChanged, this, scheduleVisibilityUpdate );
+
+	connect( &m_sortFilterProxyModel, &QSortFilterProxyModel::modelReset, this, scheduleVisibilityUpdate );
+	connect( &m_sortFilterProxyModel, &QSortFilterProxyModel::layoutChanged, this, scheduleVisibilityUpdate );
+	connect( &m_sortFilterProxyModel, &QSortFilterProxyModel::rowsInserted, this, scheduleVisibilityUpdate );
+	connect( &m_sortFilterProxyModel, &QSortFilterProxyModel::rowsRemoved, this, scheduleVisibilityUpdate );
+
 	connect( ui->listView, &QListView::doubleClicked,
 			 this, &ComputerMonitoringView::runDoubleClickFeature );
 
@@ -155,6 +172,8 @@ void ComputerMonitoringView::setComputerScreenSize( int size )
 		m_masterCore->computerManager().updateComputerScreenSize();
 
 		ui->listView->setIconSize( QSize( size, size * 9 / 16 ) );
+
+		m_visibilityUpdateTimer.start();
 	}
 }
 
@@ -231,8 +250,56 @@ void ComputerMonitoringView::runFeature( const Feature& feature )
 
 
 
+void ComputerMonitoringView::updateComputerScreenVisibility()
+{
+	if( m_masterCore == nullptr )
+	{
+		return;
+	}
+
+	QSet<int> visibleComputerIndexes;
+
+	const bool monitoringViewVisible = isVisible() && window()->isMinimized() == false;
+
+	if( monitoringViewVisible )
+	{
+		const auto viewportRect = ui->listView->viewport()->rect();
+		const auto rowCount = m_sortFilterProxyModel.rowCount();
+
+		for( int row = 0; row < rowCount; ++row )
+		{
+			const auto index = m_sortFilterProxyModel.index( row, 0 );
+			if( ui->listView->visualRect( index ).intersects( viewportRect ) )
+			{
+				visibleComputerIndexes.insert( m_sortFilterProxyModel.mapToSource( index ).row() );
+			}
+		}
+	}
+
+	m_masterCore->computerManager().updateComputerScreenVisibility( visibleComputerIndexes, monitoringViewVisible );
+}
+
+
+
+bool ComputerMonitoringView::eventFilter( QObject* object, QEvent* event )
+{
+	if( object == window() && event->type() == QEvent::WindowStateChange )
+	{
+		m_visibilityUpdateTimer.start();
+	}
+
+	return QWidget::eventFilter( object, event );
+}
+
+
+
 void ComputerMonitoringView::showEvent( QShowEvent* event )
 {
+	// get notified when the main window gets minimized or restored
+	window()->installEventFilter( this );
+
+	m_visibilityUpdateTimer.start();
+
 	if( event->spontaneous() == false &&
 			VeyonCore::config().autoAdjustGridSize() )
 	{
@@ -244,6 +311,24 @@ void ComputerMonitoringView::showEvent( QShowEvent* event )
 
 
 
+void ComputerMonitoringView::hideEvent( QHideEvent* event )
+{
+	m_visibilityUpdateTimer.start();
+
+	QWidget::hideEvent( event );
+}
+
+
+
+void ComputerMonitoringView::resizeEvent( QResizeEvent* event )
+{
+	m_visibilityUpdateTimer.start();
+
+	QWidget::resizeEvent( event );
+}
+
+
+
 void ComputerMonitoringView::wheelEvent( QWheelEvent* event )
 {
 	if( event->modifiers().testFlag( Qt::ControlModifier ) )
@@ -29,6 +29,7 @@
 #include "Feature.h"
 
 #include <QSortFilterProxyModel>
+#include <QTimer>
 #include <QWidget>
 
 class QMenu;
@@ -46,7 +47,8 @@ public:
 	enum {
 		MinimumComputerScreenSize = 50,
 		MaximumComputerScreenSize = 1000,
-		DefaultComputerScreenSize = 150
+		DefaultComputerScreenSize = 150,
+		VisibilityUpdateDelay = 250
 	};
 
 	ComputerMonitoringView( QWidget *parent = nullptr );
@@ -65,9 +67,13 @@ private slots:
 	void runDoubleClickFeature( const QModelIndex& index );
 	void showContextMenu( QPoint pos );
 	void runFeature( const Feature& feature );
+	void updateComputerScreenVisibility();
 
 private:
+	bool eventFilter( QObject* object, QEvent* event ) override;
 	void showEvent( QShowEvent* event ) override;
+	void hideEvent( QHideEvent* event ) override;
+	void resizeEvent( QResizeEvent* event ) override;
 	void wheelEvent( QWheelEvent* event ) override;
 
 	FeatureUidList activeFeatures( const ComputerControlInterfaceList& computerControlInterfaces );
@@ -80,6 +86,7 @@ private:
 	QMenu* m_featureMenu;
 	ComputerListModel* m_computerListModel;
 	QSortFilterProxyModel m_sortFilterProxyModel;
+	QTimer m_visibilityUpdateTimer;
 
 signals:
 	void computerScreenSizeAdjusted( int size );
@@ -24,19 +24,26 @@
 
 #include <QApplication>
 #include <QDesktopWidget>
+#include <QHostAddress>
 #include <QIcon>
 #include <QLayout>
 
 #include "DemoClient.h"
+#include "DemoMulticastClient.h"
 #include "VeyonConfiguration.h"
 #include "LocalSystem.h"
 #include "LockWidget.h"
 #include "VncView.h"
 
 
-DemoClient::DemoClient( const QString& host, bool fullscreen, QObject* parent ) :
+DemoClient::DemoClient( const QString& host, bool fullscreen,
+						const QString& multicastGroupAddress, int multicastPort, QObject* parent ) :
 	QObject( parent ),
-	m_toplevel( nullptr )
+	m_toplevel( nullptr ),
+	m_vncView( nullptr ),
+	m_multicastClient( nullptr ),
+	m_fallbackHost(),
+	m_fallbackTimer( this )
 {
 	if( fullscreen )
 	{
@@ -57,7 +64,18 @@ DemoClient::DemoClient( const QString& host, bool fullscreen, QObject* parent )
 		m_toplevel->resize( QApplication::desktop()->availableGeometry( m_toplevel ).size() - QSize( 10, 30 ) );
 	}
 
-	m_vncView = new VncView( host, VeyonCore::config().demoServerPort(), m_toplevel, VncView::DemoMode );
+	if( multicastPort > 0 )
+	{
+		// let the view connect to local multicast receiver instead of the demo server
+		m_multicastClient = new DemoMulticastClient( VeyonCore::authenticationCredentials().token(), host,
+													 QHostAddress( multicastGroupAddress ), multicastPort, this );
+		m_vncView = new VncView( QHostAddress( QHostAddress::LocalHost ).toString(), m_multicastClient->localPort(),
+								 m_toplevel, VncView::DemoMode );
+	}
+	else
+	{
+		m_vncView = new VncView( host, VeyonCore::config().demoServerPort(), m_toplevel, VncView::DemoMode );
+	}
 
 	auto toplevelLayout = new QVBoxLayout;
 	toplevelLayout->setMargin( 0 );
@@ -93,6 +111,22 @@ DemoClient::~DemoClient()
 
 
 
+void DemoClient::setFallbackHost( const QString& host )
+{
+	m_fallbackHost = host;
+
+	m_fallbackTimer.setSingleShot( true );
+	m_fallbackTimer.setInterval( FallbackTimeout );
+
+	connect( &m_fallbackTimer, &QTimer::timeout, this, &DemoClient::connectToFallbackHost );
+	connect( m_vncView->vncConnection(), &VeyonVncConnection::stateChanged,
+			 this, &DemoClient::checkConnectionState );
+
+	checkConnectionState();
+}
+
+
+
 void DemoClient::viewDestroyed( QObject* obj )
 {
 	// prevent double deletion of toplevel widget
@@ -117,3 +151,36 @@ void DemoClient::resizeToplevelWidget()
 		m_toplevel->resize( m_vncView->sizeHint() );
 	}
 }
+
+
+
+void DemoClient::checkConnectionState()
+{
+	if( m_vncView->vncConnection()->state() == VeyonVncConnection::Connected )
+	{
+		m_fallbackTimer.stop();
+	}
+	else if( m_fallbackTimer.isActive() == false )
+	{
+		m_fallbackTimer.start();
+	}
+}
+
+
+
+void DemoClient::connectToFallbackHost()
+{
+	if( m_fallbackHost.isEmpty() ||
+			m_vncView->vncConnection()->state() == VeyonVncConnection::Connected )
+	{
+		return;
+	}
+
+	qWarning() << "DemoClient: relay" << m_vncView->vncConnection()->host()
+			   << "unreachable - connecting to" << m_fallbackHost;
+
+	m_vncView->vncConnection()->disconnect( this );
+	m_vncView->vncConnection()->reset( m_fallbackHost );
+
+	m_fallbackHost.clear();
+}
@@ -26,25 +26,40 @@
 #define DEMO_CLIENT_H
 
 #include <QObject>
+#include <QTimer>
 
+class DemoMulticastClient;
 class VncView;
 
 class DemoClient : public QObject
 {
 	Q_OBJECT
 public:
-	DemoClient( const QString& host, bool fullscreen, QObject* parent = nullptr );
+	DemoClient( const QString& host, bool fullscreen,
+				const QString& multicastGroupAddress = QString(), int multicastPort = 0,
+				QObject* parent = nullptr );
 	~DemoClient() override;
 
+	// connect to given host instead if the view can't connect within FallbackTimeout
+	void setFallbackHost( const QString& host );
 
 private slots:
 	void viewDestroyed( QObject* obj );
 	void resizeToplevelWidget();
-
+	void checkConnectionState();
+	void connectToFallbackHost();
 
 private:
+	enum {
+		FallbackTimeout = 10000
+	};
+
 	QWidget* m_toplevel;
 	VncView* m_vncView;
+	DemoMulticastClient* m_multicastClient;
+
+	QString m_fallbackHost;
+	QTimer m_fallbackTimer;
 
 } ;
 
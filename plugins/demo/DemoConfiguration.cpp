@@ -44,6 +44,16 @@ DemoConfiguration::DemoConfiguration() :
 	{
 		setMemoryLimit( DefaultMemoryLimit );
 	}
+
+	if( multicastGroupAddress().isEmpty() )
+	{
+		setMulticastGroupAddress( QStringLiteral( "239.255.114.1" ) );
+	}
+
+	if( multicastPort() <= 0 )
+	{
+		setMulticastPort( DefaultMulticastPort );
+	}
 }
 
 
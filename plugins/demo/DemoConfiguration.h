@@ -32,6 +32,10 @@
 	OP( DemoConfiguration, m_configuration, INT, framebufferUpdateInterval, setFramebufferUpdateInterval, "FramebufferUpdateInterval", "Demo" );	\
 	OP( DemoConfiguration, m_configuration, INT, keyFrameInterval, setKeyFrameInterval, "KeyFrameInterval", "Demo" );	\
 	OP( DemoConfiguration, m_configuration, INT, memoryLimit, setMemoryLimit, "MemoryLimit", "Demo" );	\
+	OP( DemoConfiguration, m_configuration, BOOL, multicastEnabled, setMulticastEnabled, "MulticastEnabled", "Demo" );	\
+	OP( DemoConfiguration, m_configuration, STRING, multicastGroupAddress, setMulticastGroupAddress, "MulticastGroupAddress", "Demo" );	\
+	OP( DemoConfiguration, m_configuration, INT, multicastPort, setMulticastPort, "MulticastPort", "Demo" );	\
+	OP( DemoConfiguration, m_configuration, INT, relayFanOut, setRelayFanOut, "RelayFanOut", "Demo" );	\
 
 // clazy:excludeall=ctor-missing-parent-argument
 
@@ -43,6 +47,7 @@ public:
 		DefaultFramebufferUpdateInterval = 100,	// in milliseconds
 		DefaultKeyFrameInterval = 10,			// in seconds
 		DefaultMemoryLimit = 128,				// in MB
+		DefaultMulticastPort = 11410,
 	};
 
 	DemoConfiguration();
@@ -54,6 +59,10 @@ public slots:
 	void setFramebufferUpdateInterval( int );
 	void setKeyFrameInterval( int );
 	void setMemoryLimit( int );
+	void setMulticastEnabled( bool );
+	void setMulticastGroupAddress( const QString& );
+	void setMulticastPort( int );
+	void setRelayFanOut( int );
 
 } ;
 
@@ -34,9 +34,6 @@ DemoConfigurationPage::DemoConfigurationPage( DemoConfiguration& configuration,
 	m_configuration( configuration )
 {
 	ui->setupUi(this);
-
-	// MT not supported yet
-	ui->multithreadingEnabled->setVisible( false );
 }
 
 
@@ -66,6 +63,11 @@ void DemoConfigurationPage::resetWidgets()
 		m_configuration.setMemoryLimit( DemoConfiguration::DefaultMemoryLimit );
 	}
 
+	if( m_configuration.multicastPort() < ui->multicastPort->minimum() )
+	{
+		m_configuration.setMulticastPort( DemoConfiguration::DefaultMulticastPort );
+	}
+
 	FOREACH_DEMO_CONFIG_PROPERTY(INIT_WIDGET_FROM_PROPERTY);
 }
 
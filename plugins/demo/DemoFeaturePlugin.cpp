@@ -23,6 +23,7 @@
  */
 
 #include <QCoreApplication>
+#include <QHostAddress>
 
 #include "AuthenticationCredentials.h"
 #include "Computer.h"
@@ -59,7 +60,8 @@ DemoFeaturePlugin::DemoFeaturePlugin( QObject* parent ) :
 	m_demoAccessToken( CryptoCore::generateChallenge().toBase64() ),
 	m_demoClientHosts(),
 	m_demoServer( nullptr ),
-	m_demoClient( nullptr )
+	m_demoClient( nullptr ),
+	m_demoRelay( nullptr )
 {
 }
 
@@ -90,8 +92,59 @@ bool DemoFeaturePlugin::startMasterFeature( const Feature& feature,
 
 		qDebug() << "DemoFeaturePlugin::startMasterFeature(): clients:" << m_demoClientHosts;
 
-		return sendFeatureMessage( FeatureMessage( feature.uid(), StartDemoClient ).addArgument( DemoAccessToken, m_demoAccessToken ),
-								   computerControlInterfaces );
+		FeatureMessage startDemoClientMessage( feature.uid(), StartDemoClient );
+		startDemoClientMessage.addArgument( DemoAccessToken, m_demoAccessToken );
+
+		if( m_configuration.multicastEnabled() )
+		{
+			startDemoClientMessage.addArgument( MulticastGroupAddress, m_configuration.multicastGroupAddress() );
+			startDemoClientMessage.addArgument( MulticastPort, m_configuration.multicastPort() );
+		}
+
+		const int relayFanOut = m_configuration.multicastEnabled() ? 0 : m_configuration.relayFanOut();
+
+		// only computers we're connected to can serve as relays - all others
+		// connect to the demo server directly once they're online
+		ComputerControlInterfaceList connectedInterfaces;
+		ComputerControlInterfaceList otherInterfaces;
+
+		for( auto computerControlInterface : computerControlInterfaces )
+		{
+			if( computerControlInterface->state() == ComputerControlInterface::Connected )
+			{
+				connectedInterfaces += computerControlInterface;
+			}
+			else
+			{
+				otherInterfaces += computerControlInterface;
+			}
+		}
+
+		if( relayFanOut <= 0 || connectedInterfaces.size() <= relayFanOut )
+		{
+			return sendFeatureMessage( startDemoClientMessage, computerControlInterfaces );
+		}
+
+		sendFeatureMessage( startDemoClientMessage, otherInterfaces );
+
+		// build a tree of relays so the demo server only serves the first clients
+		// directly - client i relays the demo to clients (i+1)*F ... (i+2)*F-1
+		for( int i = 0; i < connectedInterfaces.size(); ++i )
+		{
+			FeatureMessage relayStartDemoClientMessage( startDemoClientMessage );
+
+			if( i >= relayFanOut )
+			{
+				const auto relay = connectedInterfaces[( i - relayFanOut ) / relayFanOut];
+				relayStartDemoClientMessage.addArgument( RelayServerHost, relay->computer().hostAddress() );
+			}
+
+			relayStartDemoClientMessage.addArgument( RelayEnabled, ( i + 1 ) * relayFanOut < connectedInterfaces.size() );
+
+			sendFeatureMessage( relayStartDemoClientMessage, { connectedInterfaces[i] } );
+		}
+
+		return true;
 	}
 
 	return false;
@@ -198,9 +251,22 @@ bool DemoFeaturePlugin::handleServiceFeatureMessage( const FeatureMessage& messa
 		if( message.command() == StartDemoClient )
 		{
 			// construct a new message as we have to append the peer address as demo server host
+			// unless the master assigned a relay to us - then it's used if the relay is unreachable
+			auto demoServerHost = socket->peerAddress().toString();
+			QString fallbackServerHost;
+			if( message.hasArgument( RelayServerHost ) )
+			{
+				fallbackServerHost = demoServerHost;
+				demoServerHost = message.argument( RelayServerHost ).toString();
+			}
+
 			FeatureMessage startDemoClientMessage( message.featureUid(), message.command() );
 			startDemoClientMessage.addArgument( DemoAccessToken, message.argument( DemoAccessToken ) );
-			startDemoClientMessage.addArgument( DemoServerHost, socket->peerAddress().toString() );
+			startDemoClientMessage.addArgument( DemoServerHost, demoServerHost );
+			startDemoClientMessage.addArgument( FallbackServerHost, fallbackServerHost );
+			startDemoClientMessage.addArgument( MulticastGroupAddress, message.argument( MulticastGroupAddress ) );
+			startDemoClientMessage.addArgument( MulticastPort, message.argument( MulticastPort ) );
+			startDemoClientMessage.addArgument( RelayEnabled, message.argument( RelayEnabled ) );
 			featureWorkerManager.sendMessage( startDemoClientMessage );
 		}
 		else
@@ -253,11 +319,29 @@ bool DemoFeaturePlugin::handleWorkerFeatureMessage( const FeatureMessage& messag
 
 			if( m_demoClient == nullptr )
 			{
-				const auto demoServerHost = message.argument( DemoServerHost ).toString();
+				auto demoServerHost = message.argument( DemoServerHost ).toString();
+				auto fallbackServerHost = message.argument( FallbackServerHost ).toString();
 				const auto isFullscreenDemo = message.featureUid() == m_fullscreenDemoFeature.uid();
 
+				if( message.argument( RelayEnabled ).toBool() && m_demoRelay == nullptr )
+				{
+					// re-serve the demo to further clients and watch it via the local relay
+					m_demoRelay = new DemoServer( demoServerHost, fallbackServerHost,
+												  message.argument( DemoAccessToken ).toString(),
+												  m_configuration, this );
+					demoServerHost = QHostAddress( QHostAddress::LocalHost ).toString();
+					fallbackServerHost.clear();
+				}
+
 				qDebug() << "DemoClient: connecting with master" << demoServerHost;
-				m_demoClient = new DemoClient( demoServerHost, isFullscreenDemo );
+				m_demoClient = new DemoClient( demoServerHost, isFullscreenDemo,
+											   message.argument( MulticastGroupAddress ).toString(),
+											   message.argument( MulticastPort ).toInt() );
+
+				if( fallbackServerHost.isEmpty() == false )
+				{
+					m_demoClient->setFallbackHost( fallbackServerHost );
+				}
 			}
 			return true;
 
@@ -265,6 +349,9 @@ bool DemoFeaturePlugin::handleWorkerFeatureMessage( const FeatureMessage& messag
 			delete m_demoClient;
 			m_demoClient = nullptr;
 
+			delete m_demoRelay;
+			m_demoRelay = nullptr;
+
 			QCoreApplication::quit();
 
 			return true;
@@ -109,6 +109,11 @@ private:
 		VncServerPort,
 		VncServerPassword,
 		DemoServerHost,
+		MulticastGroupAddress,
+		MulticastPort,
+		RelayServerHost,
+		RelayEnabled,
+		FallbackServerHost,
 	};
 
 	Feature m_fullscreenDemoFeature;
@@ -123,6 +128,7 @@ private:
 
 	DemoServer* m_demoServer;
 	DemoClient* m_demoClient;
+	DemoServer* m_demoRelay;
 
 };
 
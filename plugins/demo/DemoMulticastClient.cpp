@@ -0,0 +1,534 @@
+/*
+ * DemoMulticastClient.cpp - implementation of DemoMulticastClient class
+ *
+ * Copyright (c) 2017 Tobias Junghans <tobydox@users.sf.net>
+ *
+ * This file is part of Veyon - http://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include <QDataStream>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUdpSocket>
+
+#include "DemoMulticastClient.h"
+#include "DemoMulticastServer.h"
+#include "DemoServerProtocol.h"
+#include "VariantArrayMessage.h"
+#include "VncServerClient.h"
+
+
+DemoMulticastClient::DemoMulticastClient( const QString& demoAccessToken, const QString& demoServerHost,
+										  const QHostAddress& groupAddress, int port, QObject* parent ) :
+	QObject( parent ),
+	m_demoAccessToken( demoAccessToken ),
+	m_datagramKey( demoAccessToken.toUtf8() ),
+	m_demoServerHost( demoServerHost ),
+	m_groupAddress( groupAddress ),
+	m_port( static_cast<quint16>( port ) ),
+	m_controlSocket( new QTcpSocket( this ) ),
+	m_multicastSocket( new QUdpSocket( this ) ),
+	m_localServer( new QTcpServer( this ) ),
+	m_localSocket( nullptr ),
+	m_vncServerClient( nullptr ),
+	m_localProtocol( nullptr ),
+	m_serverInitMessage(),
+	m_keyFrameRequested( false ),
+	m_demoServerAddress(),
+	m_sessionId(),
+	m_nextMessageSequence( -1 ),
+	m_endMessageSequence( 0 ),
+	m_pendingMessages(),
+	m_partialMessages(),
+	m_repairTimer( this ),
+	m_gapTimer(),
+	m_lastDatagram(),
+	m_lastFallbackRequest()
+{
+	if( m_localServer->listen( QHostAddress::LocalHost, 0 ) == false )
+	{
+		qCritical( "DemoMulticastClient: could not listen for local connections!" );
+	}
+
+	connect( m_localServer, &QTcpServer::newConnection, this, &DemoMulticastClient::acceptLocalConnection );
+
+	if( m_multicastSocket->bind( QHostAddress::AnyIPv4, m_port, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint ) == false ||
+			m_multicastSocket->joinMulticastGroup( m_groupAddress ) == false )
+	{
+		// we'll fall back to fetching key frames via control connection
+		qWarning() << "DemoMulticastClient: could not join multicast group" << m_groupAddress.toString()
+				   << m_multicastSocket->errorString();
+	}
+
+	// large updates arrive as bursts of datagrams
+	m_multicastSocket->setSocketOption( QAbstractSocket::ReceiveBufferSizeSocketOption, 4*1024*1024 );
+
+	connect( m_multicastSocket, &QUdpSocket::readyRead, this, &DemoMulticastClient::readDatagrams );
+
+	connect( m_controlSocket, &QTcpSocket::connected, this, [=]() {
+		VariantArrayMessage( m_controlSocket ).write( DemoMulticastServer::Authenticate ).write( m_demoAccessToken ).send();
+	} );
+	connect( m_controlSocket, &QTcpSocket::readyRead, this, &DemoMulticastClient::readControlMessages );
+	connect( m_controlSocket, &QTcpSocket::stateChanged, this, [=]( QAbstractSocket::SocketState state ) {
+		if( state == QAbstractSocket::UnconnectedState )
+		{
+			m_keyFrameRequested = false;
+			QTimer::singleShot( ReconnectInterval, this, &DemoMulticastClient::connectToDemoServer );
+		}
+	} );
+
+	connect( &m_repairTimer, &QTimer::timeout, this, &DemoMulticastClient::requestMissingMessages );
+	m_repairTimer.start( RepairInterval );
+
+	connectToDemoServer();
+}
+
+
+
+DemoMulticastClient::~DemoMulticastClient()
+{
+	m_controlSocket->disconnect( this );
+
+	closeLocalConnection();
+}
+
+
+
+quint16 DemoMulticastClient::localPort() const
+{
+	return m_localServer->serverPort();
+}
+
+
+
+void DemoMulticastClient::connectToDemoServer()
+{
+	if( m_controlSocket->state() == QAbstractSocket::UnconnectedState )
+	{
+		m_controlSocket->connectToHost( m_demoServerHost, m_port );
+	}
+}
+
+
+
+void DemoMulticastClient::acceptLocalConnection()
+{
+	while( m_localServer->hasPendingConnections() )
+	{
+		auto socket = m_localServer->nextPendingConnection();
+
+		// VncView reconnected? then start over
+		closeLocalConnection();
+
+		m_localSocket = socket;
+		m_vncServerClient = new VncServerClient;
+		m_localProtocol = new DemoServerProtocol( m_demoAccessToken, m_localSocket, m_vncServerClient );
+
+		connect( m_localSocket, &QTcpSocket::readyRead, this, &DemoMulticastClient::processLocalClient );
+		connect( m_localSocket, &QTcpSocket::disconnected, this, &DemoMulticastClient::closeLocalConnection );
+
+		// new local client needs a key frame first
+		m_nextMessageSequence = -1;
+
+		startLocalProtocol();
+	}
+}
+
+
+
+void DemoMulticastClient::processLocalClient()
+{
+	if( m_localProtocol == nullptr || m_localProtocol->state() == VncServerProtocol::Disconnected )
+	{
+		return;
+	}
+
+	if( m_localProtocol->state() != VncServerProtocol::Running )
+	{
+		while( m_localProtocol->read() )
+		{
+		}
+
+		if( m_localProtocol->state() == VncServerProtocol::Running )
+		{
+			requestKeyFrame();
+		}
+		else
+		{
+			QTimer::singleShot( ProtocolRetryTime, this, &DemoMulticastClient::processLocalClient );
+		}
+	}
+	else
+	{
+		// we push all updates anyway so there's no need to handle client messages
+		m_localSocket->readAll();
+	}
+}
+
+
+
+void DemoMulticastClient::readControlMessages()
+{
+	VariantArrayMessage message( m_controlSocket );
+
+	while( message.isReadyForReceive() )
+	{
+		if( message.receive() == false || processControlMessage( message ) == false )
+		{
+			m_controlSocket->close();
+			return;
+		}
+	}
+}
+
+
+
+void DemoMulticastClient::readDatagrams()
+{
+	while( m_multicastSocket->hasPendingDatagrams() )
+	{
+		QByteArray datagram( static_cast<int>( m_multicastSocket->pendingDatagramSize() ), Qt::Uninitialized );
+		QHostAddress sender;
+		if( m_multicastSocket->readDatagram( datagram.data(), datagram.size(), &sender ) == datagram.size() )
+		{
+			processDatagram( datagram, sender );
+		}
+	}
+
+	writePendingMessages();
+}
+
+
+
+void DemoMulticastClient::requestMissingMessages()
+{
+	if( m_controlSocket->state() != QAbstractSocket::ConnectedState ||
+			m_localProtocol == nullptr || m_localProtocol->state() != VncServerProtocol::Running )
+	{
+		return;
+	}
+
+	if( m_nextMessageSequence < 0 )
+	{
+		requestKeyFrame();
+		return;
+	}
+
+	// multicast not working at all? then at least keep the screen up to date with key frames
+	if( m_lastDatagram.isValid() == false || m_lastDatagram.elapsed() > FallbackTimeout )
+	{
+		if( m_lastFallbackRequest.isValid() == false || m_lastFallbackRequest.elapsed() > FallbackTimeout )
+		{
+			qDebug( "DemoMulticastClient: no multicast data received - requesting key frame" );
+			requestKeyFrame();
+			m_lastFallbackRequest.restart();
+		}
+		return;
+	}
+
+	const auto missingEnd = m_pendingMessages.isEmpty() ? m_endMessageSequence : m_pendingMessages.firstKey();
+
+	if( m_nextMessageSequence >= missingEnd )
+	{
+		m_gapTimer.invalidate();
+		return;
+	}
+
+	// give datagrams still in flight some time before requesting missing messages
+	if( m_gapTimer.isValid() == false )
+	{
+		m_gapTimer.start();
+	}
+	else if( m_gapTimer.elapsed() >= RepairTimeout )
+	{
+		const auto missingCount = missingEnd - m_nextMessageSequence;
+		if( missingCount > MaximumResendCount )
+		{
+			requestKeyFrame();
+		}
+		else
+		{
+			resendMessages( m_nextMessageSequence, static_cast<int>( missingCount ) );
+		}
+		m_gapTimer.restart();
+	}
+}
+
+
+
+bool DemoMulticastClient::processControlMessage( VariantArrayMessage& message )
+{
+	switch( message.read().toInt() )
+	{
+	case DemoMulticastServer::ServerInit:
+		m_serverInitMessage = message.read().toByteArray();
+		m_sessionId = message.read().toByteArray();
+		m_endMessageSequence = qMax( m_endMessageSequence, message.read().toLongLong() );
+		m_demoServerAddress = m_controlSocket->peerAddress();
+		startLocalProtocol();
+		return true;
+
+	case DemoMulticastServer::KeyFrame:
+	{
+		const auto sequence = message.read().toLongLong();
+		m_endMessageSequence = qMax( m_endMessageSequence, sequence );
+		writeKeyFrame( sequence, message.read().toByteArray() );
+		return true;
+	}
+
+	case DemoMulticastServer::Message:
+	{
+		const auto sequence = message.read().toLongLong();
+		m_endMessageSequence = qMax( m_endMessageSequence, sequence + 1 );
+		addMessage( sequence, message.read().toByteArray() );
+		writePendingMessages();
+		return true;
+	}
+
+	default:
+		break;
+	}
+
+	qWarning( "DemoMulticastClient: invalid control message" );
+
+	return false;
+}
+
+
+
+void DemoMulticastClient::processDatagram( const QByteArray& datagram, const QHostAddress& sender )
+{
+	if( m_sessionId.isEmpty() ||
+			datagram.size() < DemoMulticastServer::DatagramHeaderSize + DemoMulticastServer::DatagramMacSize ||
+			sender.toIPv4Address() != m_demoServerAddress.toIPv4Address() )
+	{
+		return;
+	}
+
+	const auto macOffset = datagram.size() - DemoMulticastServer::DatagramMacSize;
+	const auto signedData = QByteArray::fromRawData( datagram.constData(), macOffset );
+
+	if( DemoMulticastServer::datagramMac( signedData, m_datagramKey ) != datagram.mid( macOffset ) )
+	{
+		return;
+	}
+
+	QDataStream stream( signedData );
+
+	quint32 magic = 0;
+	QByteArray sessionId( DemoMulticastServer::DatagramSessionIdSize, '\0' );
+	qint64 sequence = 0;
+	quint16 fragmentIndex = 0;
+	quint16 fragmentCount = 0;
+	stream >> magic;
+	stream.readRawData( sessionId.data(), sessionId.size() );
+	stream >> sequence >> fragmentIndex >> fragmentCount;
+
+	// ignore datagrams of other demos as well as sequence numbers far beyond
+	// what we know has been sent so far so they can't stall the stream
+	if( magic != DemoMulticastServer::DatagramMagic || sessionId != m_sessionId ||
+			sequence < 0 || sequence > m_endMessageSequence + MaximumSequenceLead )
+	{
+		return;
+	}
+
+	m_lastDatagram.restart();
+
+	// heartbeat?
+	if( fragmentCount == 0 )
+	{
+		m_endMessageSequence = qMax( m_endMessageSequence, sequence );
+		return;
+	}
+
+	m_endMessageSequence = qMax( m_endMessageSequence, sequence + 1 );
+
+	if( fragmentIndex >= fragmentCount ||
+			( m_nextMessageSequence >= 0 && sequence < m_nextMessageSequence ) ||
+			m_pendingMessages.contains( sequence ) )
+	{
+		return;
+	}
+
+	const auto payload = signedData.mid( DemoMulticastServer::DatagramHeaderSize );
+
+	if( fragmentCount == 1 )
+	{
+		addMessage( sequence, payload );
+		return;
+	}
+
+	// limit memory used for messages whose remaining fragments never arrive -
+	// the oldest ones are requested via the control connection anyway
+	if( m_partialMessages.contains( sequence ) == false && m_partialMessages.size() >= MaximumPartialMessages )
+	{
+		if( sequence < m_partialMessages.firstKey() )
+		{
+			return;
+		}
+		m_partialMessages.erase( m_partialMessages.begin() );
+	}
+
+	auto& partialMessage = m_partialMessages[sequence];
+	if( partialMessage.fragments.size() != fragmentCount )
+	{
+		partialMessage.fragments = QVector<QByteArray>( fragmentCount );
+		partialMessage.missingFragments = fragmentCount;
+	}
+
+	if( partialMessage.fragments[fragmentIndex].isNull() )
+	{
+		partialMessage.fragments[fragmentIndex] = payload;
+		--partialMessage.missingFragments;
+	}
+
+	if( partialMessage.missingFragments <= 0 )
+	{
+		QByteArray message;
+		for( const auto& fragment : qAsConst( partialMessage.fragments ) )
+		{
+			message.append( fragment );
+		}
+
+		m_partialMessages.remove( sequence );
+
+		addMessage( sequence, message );
+	}
+}
+
+
+
+void DemoMulticastClient::addMessage( qint64 sequence, const QByteArray& message )
+{
+	if( m_nextMessageSequence >= 0 && sequence < m_nextMessageSequence )
+	{
+		return;
+	}
+
+	m_pendingMessages[sequence] = message;
+	m_partialMessages.remove( sequence );
+
+	while( m_pendingMessages.size() > MaximumPendingMessages )
+	{
+		m_pendingMessages.erase( m_pendingMessages.begin() );
+	}
+}
+
+
+
+void DemoMulticastClient::writeKeyFrame( qint64 sequence, const QByteArray& keyFrame )
+{
+	m_keyFrameRequested = false;
+
+	if( m_localProtocol == nullptr || m_localProtocol->state() != VncServerProtocol::Running ||
+			( m_nextMessageSequence >= 0 && sequence <= m_nextMessageSequence ) )
+	{
+		return;
+	}
+
+	m_localSocket->write( keyFrame );
+	m_nextMessageSequence = sequence;
+
+	writePendingMessages();
+}
+
+
+
+void DemoMulticastClient::writePendingMessages()
+{
+	if( m_localProtocol == nullptr || m_localProtocol->state() != VncServerProtocol::Running ||
+			m_nextMessageSequence < 0 )
+	{
+		return;
+	}
+
+	while( m_pendingMessages.isEmpty() == false && m_pendingMessages.firstKey() <= m_nextMessageSequence )
+	{
+		if( m_pendingMessages.firstKey() == m_nextMessageSequence )
+		{
+			m_localSocket->write( m_pendingMessages.first() );
+			++m_nextMessageSequence;
+		}
+
+		m_pendingMessages.erase( m_pendingMessages.begin() );
+	}
+
+	for( auto it = m_partialMessages.begin(); it != m_partialMessages.end(); )
+	{
+		if( it.key() < m_nextMessageSequence )
+		{
+			it = m_partialMessages.erase( it );
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+
+
+void DemoMulticastClient::startLocalProtocol()
+{
+	if( m_localProtocol && m_serverInitMessage.isEmpty() == false &&
+			m_localProtocol->state() == VncServerProtocol::Disconnected )
+	{
+		m_localProtocol->setServerInitMessage( m_serverInitMessage );
+		m_localProtocol->start();
+
+		processLocalClient();
+	}
+}
+
+
+
+void DemoMulticastClient::closeLocalConnection()
+{
+	delete m_localProtocol;
+	m_localProtocol = nullptr;
+
+	delete m_vncServerClient;
+	m_vncServerClient = nullptr;
+
+	if( m_localSocket )
+	{
+		m_localSocket->disconnect( this );
+		m_localSocket->deleteLater();
+		m_localSocket = nullptr;
+	}
+}
+
+
+
+void DemoMulticastClient::requestKeyFrame()
+{
+	if( m_keyFrameRequested == false && m_controlSocket->state() == QAbstractSocket::ConnectedState )
+	{
+		VariantArrayMessage( m_controlSocket ).write( DemoMulticastServer::RequestKeyFrame ).send();
+		m_keyFrameRequested = true;
+	}
+}
+
+
+
+void DemoMulticastClient::resendMessages( qint64 firstSequence, int count )
+{
+	VariantArrayMessage( m_controlSocket ).write( DemoMulticastServer::ResendMessages ).
+			write( firstSequence ).write( count ).send();
+}
@@ -0,0 +1,127 @@
+/*
+ * DemoMulticastClient.h - header file for DemoMulticastClient class
+ *
+ * Copyright (c) 2017 Tobias Junghans <tobydox@users.sf.net>
+ *
+ * This file is part of Veyon - http://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef DEMO_MULTICAST_CLIENT_H
+#define DEMO_MULTICAST_CLIENT_H
+
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QMap>
+#include <QTimer>
+#include <QVector>
+
+class DemoServerProtocol;
+class QTcpServer;
+class QTcpSocket;
+class QUdpSocket;
+class VariantArrayMessage;
+class VncServerClient;
+
+// receives the multicast demo stream sent by DemoMulticastServer and serves it
+// to the local demo VncView like a regular demo server - initial screen contents
+// and lost messages are fetched via a TCP control connection to the demo server
+class DemoMulticastClient : public QObject
+{
+	Q_OBJECT
+public:
+	DemoMulticastClient( const QString& demoAccessToken, const QString& demoServerHost,
+						 const QHostAddress& groupAddress, int port, QObject* parent = nullptr );
+	~DemoMulticastClient() override;
+
+	quint16 localPort() const;
+
+private slots:
+	void connectToDemoServer();
+	void acceptLocalConnection();
+	void processLocalClient();
+	void readControlMessages();
+	void readDatagrams();
+	void requestMissingMessages();
+
+private:
+	enum {
+		ProtocolRetryTime = 250,
+		ReconnectInterval = 1000,
+		RepairInterval = 100,
+		RepairTimeout = 250,
+		FallbackTimeout = 3000,
+		MaximumPendingMessages = 4096,
+		MaximumPartialMessages = 32,
+		MaximumSequenceLead = MaximumPendingMessages,
+		MaximumResendCount = 256
+	};
+
+	struct PartialMessage
+	{
+		QVector<QByteArray> fragments;
+		int missingFragments;
+	} ;
+
+	bool processControlMessage( VariantArrayMessage& message );
+	void processDatagram( const QByteArray& datagram, const QHostAddress& sender );
+	void addMessage( qint64 sequence, const QByteArray& message );
+	void writeKeyFrame( qint64 sequence, const QByteArray& keyFrame );
+	void writePendingMessages();
+	void startLocalProtocol();
+	void closeLocalConnection();
+	void requestKeyFrame();
+	void resendMessages( qint64 firstSequence, int count );
+
+	const QString m_demoAccessToken;
+	const QByteArray m_datagramKey;
+	const QString m_demoServerHost;
+	const QHostAddress m_groupAddress;
+	const quint16 m_port;
+
+	QTcpSocket* m_controlSocket;
+	QUdpSocket* m_multicastSocket;
+	QTcpServer* m_localServer;
+	QTcpSocket* m_localSocket;
+
+	VncServerClient* m_vncServerClient;
+	DemoServerProtocol* m_localProtocol;
+
+	QByteArray m_serverInitMessage;
+	bool m_keyFrameRequested;
+
+	// datagrams are only accepted from the demo server and with the session ID
+	// received via the authenticated control connection
+	QHostAddress m_demoServerAddress;
+	QByteArray m_sessionId;
+
+	// sequence number of next message to pass to local client, -1 until first key frame
+	qint64 m_nextMessageSequence;
+	qint64 m_endMessageSequence;
+
+	QMap<qint64, QByteArray> m_pendingMessages;
+	QMap<qint64, PartialMessage> m_partialMessages;
+
+	QTimer m_repairTimer;
+	QElapsedTimer m_gapTimer;
+	QElapsedTimer m_lastDatagram;
+	QElapsedTimer m_lastFallbackRequest;
+
+} ;
+
+#endif
@@ -0,0 +1,323 @@
+/*
+ * DemoMulticastServer.cpp - implementation of DemoMulticastServer class
+ *
+ * Copyright (c) 2017 Tobias Junghans <tobydox@users.sf.net>
+ *
+ * This file is part of Veyon - http://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include <QDataStream>
+#include <QMessageAuthenticationCode>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUdpSocket>
+
+#include "CryptoCore.h"
+#include "DemoMulticastServer.h"
+#include "DemoServer.h"
+#include "VariantArrayMessage.h"
+
+
+DemoMulticastServer::DemoMulticastServer( DemoServer* demoServer, const QString& demoAccessToken,
+										  const QHostAddress& groupAddress, int port, QObject* parent ) :
+	QObject( parent ),
+	m_demoServer( demoServer ),
+	m_demoAccessToken( demoAccessToken ),
+	m_datagramKey( demoAccessToken.toUtf8() ),
+	m_sessionId( CryptoCore::generateChallenge().left( DatagramSessionIdSize ) ),
+	m_groupAddress( groupAddress ),
+	m_port( static_cast<quint16>( port ) ),
+	m_multicastSocket( new QUdpSocket( this ) ),
+	m_controlServer( new QTcpServer( this ) ),
+	m_authenticatedSockets(),
+	m_heartbeatTimer( this )
+{
+	connect( m_controlServer, &QTcpServer::newConnection, this, &DemoMulticastServer::acceptControlConnections );
+
+	if( m_controlServer->listen( QHostAddress::Any, m_port ) == false )
+	{
+		qCritical() << "DemoMulticastServer: could not listen on control port" << m_port;
+	}
+
+	// only serve control connections (e.g. for relays) without group address
+	if( m_groupAddress.isNull() == false )
+	{
+		// also deliver datagrams to receivers on the same host (e.g. for testing on loopback)
+		m_multicastSocket->setSocketOption( QAbstractSocket::MulticastLoopbackOption, 1 );
+		m_multicastSocket->setSocketOption( QAbstractSocket::MulticastTtlOption, 1 );
+
+		connect( &m_heartbeatTimer, &QTimer::timeout, this, &DemoMulticastServer::sendHeartbeat );
+		m_heartbeatTimer.start( HeartbeatInterval );
+
+		qDebug() << "DemoMulticastServer: sending updates to" << m_groupAddress.toString() << m_port;
+	}
+}
+
+
+
+DemoMulticastServer::~DemoMulticastServer()
+{
+	m_controlServer->disconnect( this );
+
+	for( auto socket : qAsConst( m_authenticatedSockets ) )
+	{
+		socket->disconnect( this );
+	}
+}
+
+
+
+void DemoMulticastServer::sendMessage( qint64 sequence, const QByteArray& message )
+{
+	for( auto it = m_subscribers.begin(); it != m_subscribers.end(); ++it )
+	{
+		auto socket = it.key();
+
+		// subscriber does not keep up? then resync it with a key frame later
+		if( socket->bytesToWrite() > MaximumSubscriberBacklogSize )
+		{
+			it.value() = -1;
+		}
+		else if( it.value() < 0 )
+		{
+			it.value() = sendKeyFrame( socket );
+		}
+		else if( sequence >= it.value() )
+		{
+			VariantArrayMessage( socket ).write( Message ).write( sequence ).write( message ).send();
+			it.value() = sequence + 1;
+		}
+	}
+
+	if( m_groupAddress.isNull() )
+	{
+		return;
+	}
+
+	const int fragmentCount = ( message.size() + MaximumDatagramPayloadSize - 1 ) / MaximumDatagramPayloadSize;
+
+	for( int i = 0; i < fragmentCount; ++i )
+	{
+		if( sendDatagram( sequence, i, fragmentCount,
+						  message.mid( i * MaximumDatagramPayloadSize, MaximumDatagramPayloadSize ) ) == false )
+		{
+			// receivers will request the message via the control connection
+			qWarning() << "DemoMulticastServer: could not send datagram:" << m_multicastSocket->errorString();
+			break;
+		}
+	}
+
+	// sending messages makes heartbeats superfluous
+	m_heartbeatTimer.start( HeartbeatInterval );
+}
+
+
+
+QByteArray DemoMulticastServer::datagramMac( const QByteArray& datagram, const QByteArray& key )
+{
+	return QMessageAuthenticationCode::hash( datagram, key, QCryptographicHash::Sha256 ).left( DatagramMacSize );
+}
+
+
+
+void DemoMulticastServer::acceptControlConnections()
+{
+	while( m_controlServer->hasPendingConnections() )
+	{
+		auto socket = m_controlServer->nextPendingConnection();
+
+		connect( socket, &QTcpSocket::readyRead, this, [=]() { readControlMessages( socket ); } );
+		connect( socket, &QTcpSocket::disconnected, this, [=]() {
+			m_authenticatedSockets.remove( socket );
+			m_subscribers.remove( socket );
+			socket->deleteLater();
+		} );
+	}
+}
+
+
+
+void DemoMulticastServer::sendHeartbeat()
+{
+	m_demoServer->lockDataForRead();
+	const auto endSequence = m_demoServer->framebufferUpdateMessages().endSequence();
+	m_demoServer->unlockData();
+
+	// a datagram without fragments lets receivers detect lost trailing messages
+	sendDatagram( endSequence, 0, 0, QByteArray() );
+}
+
+
+
+void DemoMulticastServer::readControlMessages( QTcpSocket* socket )
+{
+	VariantArrayMessage message( socket );
+
+	while( message.isReadyForReceive() )
+	{
+		if( message.receive() == false || processControlMessage( socket, message ) == false )
+		{
+			m_authenticatedSockets.remove( socket );
+			m_subscribers.remove( socket );
+			socket->close();
+			return;
+		}
+	}
+}
+
+
+
+bool DemoMulticastServer::processControlMessage( QTcpSocket* socket, VariantArrayMessage& message )
+{
+	const auto command = static_cast<ControlCommands>( message.read().toInt() );
+
+	if( m_authenticatedSockets.contains( socket ) == false )
+	{
+		if( command != Authenticate || message.read().toString() != m_demoAccessToken )
+		{
+			qWarning( "DemoMulticastServer: control connection authentication failed" );
+			return false;
+		}
+
+		const auto serverInitMessage = m_demoServer->serverInitMessage();
+		if( serverInitMessage.isEmpty() )
+		{
+			// not connected to VNC server yet - client will try again
+			return false;
+		}
+
+		m_authenticatedSockets.insert( socket );
+
+		m_demoServer->lockDataForRead();
+		const auto endSequence = m_demoServer->framebufferUpdateMessages().endSequence();
+		m_demoServer->unlockData();
+
+		VariantArrayMessage( socket ).write( ServerInit ).write( serverInitMessage ).
+				write( m_sessionId ).write( endSequence ).send();
+
+		return true;
+	}
+
+	switch( command )
+	{
+	case RequestKeyFrame:
+		if( m_subscribers.contains( socket ) )
+		{
+			m_subscribers[socket] = sendKeyFrame( socket );
+		}
+		else
+		{
+			sendKeyFrame( socket );
+		}
+		return true;
+
+	case Subscribe:
+		m_subscribers[socket] = sendKeyFrame( socket );
+		return true;
+
+	case ResendMessages:
+	{
+		const auto firstSequence = message.read().toLongLong();
+		const auto count = message.read().toInt();
+		resendMessages( socket, firstSequence, qBound<int>( 0, count, MaximumResendCount ) );
+		return true;
+	}
+
+	default:
+		break;
+	}
+
+	qWarning() << "DemoMulticastServer: invalid control command" << command;
+
+	return false;
+}
+
+
+
+qint64 DemoMulticastServer::sendKeyFrame( QTcpSocket* socket )
+{
+	qint64 sequence = 0;
+
+	m_demoServer->lockDataForRead();
+	const auto keyFrame = m_demoServer->keyFrame( &sequence );
+	m_demoServer->unlockData();
+
+	if( keyFrame.isEmpty() )
+	{
+		// no valid framebuffer yet - subscribers get one with the next message
+		if( m_subscribers.contains( socket ) == false )
+		{
+			QTimer::singleShot( HeartbeatInterval, socket, [=]() { sendKeyFrame( socket ); } );
+		}
+		return -1;
+	}
+
+	VariantArrayMessage( socket ).write( KeyFrame ).write( sequence ).write( keyFrame ).send();
+
+	return sequence;
+}
+
+
+
+void DemoMulticastServer::resendMessages( QTcpSocket* socket, qint64 firstSequence, int count )
+{
+	m_demoServer->lockDataForRead();
+
+	const auto& messages = m_demoServer->framebufferUpdateMessages();
+
+	bool messagesDiscarded = false;
+
+	for( auto sequence = firstSequence; sequence < firstSequence + count; ++sequence )
+	{
+		if( sequence < messages.firstSequence() )
+		{
+			messagesDiscarded = true;
+		}
+		else if( sequence < messages.endSequence() )
+		{
+			VariantArrayMessage( socket ).write( Message ).write( sequence ).write( messages.message( sequence ) ).send();
+		}
+	}
+
+	m_demoServer->unlockData();
+
+	// client can only resync with a key frame if requested messages are gone already
+	if( messagesDiscarded )
+	{
+		sendKeyFrame( socket );
+	}
+}
+
+
+
+bool DemoMulticastServer::sendDatagram( qint64 sequence, int fragmentIndex, int fragmentCount, const QByteArray& payload )
+{
+	QByteArray datagram;
+	datagram.reserve( DatagramHeaderSize + payload.size() + DatagramMacSize );
+
+	QDataStream stream( &datagram, QIODevice::WriteOnly );
+	stream << quint32( DatagramMagic );
+	stream.writeRawData( m_sessionId.constData(), m_sessionId.size() );
+	stream << sequence << quint16( fragmentIndex ) << quint16( fragmentCount );
+
+	datagram.append( payload );
+	datagram.append( datagramMac( datagram, m_datagramKey ) );
+
+	return m_multicastSocket->writeDatagram( datagram, m_groupAddress, m_port ) == datagram.size();
+}
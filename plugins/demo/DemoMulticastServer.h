@@ -0,0 +1,108 @@
+/*
+ * DemoMulticastServer.h - header file for DemoMulticastServer class
+ *
+ * Copyright (c) 2017 Tobias Junghans <tobydox@users.sf.net>
+ *
+ * This file is part of Veyon - http://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef DEMO_MULTICAST_SERVER_H
+#define DEMO_MULTICAST_SERVER_H
+
+#include <QHash>
+#include <QHostAddress>
+#include <QSet>
+#include <QTimer>
+
+class DemoServer;
+class QTcpServer;
+class QTcpSocket;
+class QUdpSocket;
+class VariantArrayMessage;
+
+// sends each framebuffer update message of the demo server once to a multicast
+// group - clients (see DemoMulticastClient) fetch the initial screen contents
+// as well as messages they did not receive completely via a TCP control connection,
+// relays (see DemoServer) subscribe to the whole message stream via this connection
+class DemoMulticastServer : public QObject
+{
+	Q_OBJECT
+public:
+	enum ControlCommands {
+		Authenticate,		/**< client: demo access token */
+		ServerInit,			/**< server: RFB server init message, datagram session ID, sequence number of next message */
+		RequestKeyFrame,	/**< client */
+		KeyFrame,			/**< server: sequence number of next message, key frame */
+		ResendMessages,		/**< client: sequence number of first message, message count */
+		Message,			/**< server: sequence number, message */
+		Subscribe			/**< client: receive key frame followed by all messages */
+	};
+
+	enum {
+		DatagramMagic = 0x5644454d,
+		DatagramSessionIdSize = 8,
+		DatagramHeaderSize = 4 + DatagramSessionIdSize + 8 + 2 + 2,
+		DatagramMacSize = 16,
+		MaximumDatagramPayloadSize = 1400,
+		MaximumResendCount = 256,
+		MaximumSubscriberBacklogSize = 4*1024*1024,
+		HeartbeatInterval = 1000
+	};
+
+	DemoMulticastServer( DemoServer* demoServer, const QString& demoAccessToken,
+						 const QHostAddress& groupAddress, int port, QObject* parent );
+	~DemoMulticastServer() override;
+
+	void sendMessage( qint64 sequence, const QByteArray& message );
+
+	static QByteArray datagramMac( const QByteArray& datagram, const QByteArray& key );
+
+private slots:
+	void acceptControlConnections();
+	void sendHeartbeat();
+
+private:
+	void readControlMessages( QTcpSocket* socket );
+	bool processControlMessage( QTcpSocket* socket, VariantArrayMessage& message );
+	qint64 sendKeyFrame( QTcpSocket* socket );
+	void resendMessages( QTcpSocket* socket, qint64 firstSequence, int count );
+	bool sendDatagram( qint64 sequence, int fragmentIndex, int fragmentCount, const QByteArray& payload );
+
+	DemoServer* m_demoServer;
+	const QString m_demoAccessToken;
+	const QByteArray m_datagramKey;
+
+	// identifies the datagrams of this demo so receivers can tell them apart
+	// from the ones of other demos sent to the same group
+	const QByteArray m_sessionId;
+	const QHostAddress m_groupAddress;
+	const quint16 m_port;
+
+	QUdpSocket* m_multicastSocket;
+	QTcpServer* m_controlServer;
+	QSet<QTcpSocket *> m_authenticatedSockets;
+
+	// sequence number of next message to send to each subscriber or -1 if it needs a key frame
+	QHash<QTcpSocket *, qint64> m_subscribers;
+
+	QTimer m_heartbeatTimer;
+
+} ;
+
+#endif
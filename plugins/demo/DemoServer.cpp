@@ -25,33 +25,117 @@
 
 #include <QTcpServer>
 #include <QTcpSocket>
+#include <QThread>
+
+#include <lzo/lzo1x.h>
 
 #include "DemoConfiguration.h"
+#include "DemoMulticastServer.h"
 #include "DemoServer.h"
 #include "DemoServerConnection.h"
+#include "VariantArrayMessage.h"
 #include "VeyonConfiguration.h"
 
 
 DemoServer::DemoServer( int vncServerPort, const QString& vncServerPassword, const QString& demoAccessToken,
 						const DemoConfiguration& configuration, QObject *parent ) :
+	DemoServer( vncServerPort, vncServerPassword, QString(), demoAccessToken, configuration, parent )
+{
+	if( m_tcpServer->isListening() == false )
+	{
+		return;
+	}
+
+	connect( m_vncServerSocket, &QTcpSocket::readyRead, this, &DemoServer::readFromVncServer );
+	connect( m_vncServerSocket, &QTcpSocket::disconnected, this, &DemoServer::reconnectToVncServer );
+
+	connect( &m_framebufferUpdateTimer, &QTimer::timeout, this, &DemoServer::requestFramebufferUpdate );
+
+	m_framebufferUpdateTimer.start( m_configuration.framebufferUpdateInterval() );
+
+	reconnectToVncServer();
+}
+
+
+
+DemoServer::DemoServer( const QString& upstreamHost, const QString& fallbackUpstreamHost, const QString& demoAccessToken,
+						const DemoConfiguration& configuration, QObject* parent ) :
+	DemoServer( 0, QString(), upstreamHost, demoAccessToken, configuration, parent )
+{
+	if( m_tcpServer->isListening() == false )
+	{
+		return;
+	}
+
+	m_fallbackUpstreamHost = fallbackUpstreamHost;
+	m_upstreamSocket = new QTcpSocket( this );
+
+	connect( m_upstreamSocket, &QTcpSocket::connected, this, [=]() {
+		m_failedUpstreamConnects = 0;
+		VariantArrayMessage( m_upstreamSocket ).write( DemoMulticastServer::Authenticate ).write( m_demoAccessToken ).send();
+	} );
+	connect( m_upstreamSocket, &QTcpSocket::readyRead, this, &DemoServer::readFromUpstreamServer );
+	connect( m_upstreamSocket, &QTcpSocket::stateChanged, this, [=]( QAbstractSocket::SocketState state ) {
+		if( state == QAbstractSocket::UnconnectedState )
+		{
+			// relay we've been assigned to does not come up? then connect to the demo server directly
+			if( ++m_failedUpstreamConnects >= UpstreamFallbackAttempts && m_fallbackUpstreamHost.isEmpty() == false )
+			{
+				qWarning() << "DemoServer: upstream server" << m_upstreamHost << "unreachable - falling back to"
+						   << m_fallbackUpstreamHost;
+				m_upstreamHost = m_fallbackUpstreamHost;
+				m_fallbackUpstreamHost.clear();
+			}
+
+			QTimer::singleShot( UpstreamReconnectInterval, this, &DemoServer::connectToUpstreamServer );
+		}
+	} );
+
+	qDebug() << "DemoServer: relaying demo of" << m_upstreamHost;
+
+	connectToUpstreamServer();
+}
+
+
+
+DemoServer::DemoServer( int vncServerPort, const QString& vncServerPassword, const QString& upstreamHost,
+						const QString& demoAccessToken, const DemoConfiguration& configuration, QObject *parent ) :
 	QObject( parent ),
 	m_configuration( configuration ),
 	m_vncServerPort( vncServerPort ),
+	m_upstreamHost( upstreamHost ),
+	m_fallbackUpstreamHost(),
+	m_failedUpstreamConnects( 0 ),
 	m_demoAccessToken( demoAccessToken ),
 	m_tcpServer( new QTcpServer( this ) ),
+	m_multicastServer( nullptr ),
 	m_vncServerSocket( new QTcpSocket( this ) ),
 	m_vncClientProtocol( m_vncServerSocket, vncServerPassword ),
+	m_upstreamSocket( nullptr ),
+	m_serverInitMessage(),
 	m_framebufferUpdateTimer( this ),
-	m_lastFullFramebufferUpdate(),
 	m_requestFullFramebufferUpdate( false ),
-	m_keyFrame( 0 )
+	m_framebufferUpdateMessages(),
+	m_framebuffer(),
+	m_framebufferValid( false ),
+	m_framebufferResized( false ),
+	m_initialFramebufferSize(),
+	m_updatedRegion(),
+	m_tileEncoder(),
+	m_keyFrameLock(),
+	m_keyFrameMessage(),
+	m_keyFrameSequence( -1 ),
+	m_connectionStatisticsLock(),
+	m_connectionStatistics(),
+	m_connectionThreads(),
+	m_nextConnectionThread( 0 )
 {
-	connect( m_tcpServer, &QTcpServer::newConnection, this, &DemoServer::acceptPendingConnections );
-
-	connect( m_vncServerSocket, &QTcpSocket::readyRead, this, &DemoServer::readFromVncServer );
-	connect( m_vncServerSocket, &QTcpSocket::disconnected, this, &DemoServer::reconnectToVncServer );
+	if( lzo_init() != LZO_E_OK )
+	{
+		qCritical( "DemoServer: could not initialize LZO library!" );
+	}
 
-	connect( &m_framebufferUpdateTimer, &QTimer::timeout, this, &DemoServer::requestFramebufferUpdate );
+	connect( m_tcpServer, &QTcpServer::newConnection, this, &DemoServer::acceptPendingConnections );
 
 	if( m_tcpServer->listen( QHostAddress::Any, VeyonCore::config().demoServerPort() ) == false )
 	{
@@ -59,9 +143,24 @@ DemoServer::DemoServer( int vncServerPort, const QString& vncServerPassword, con
 		return;
 	}
 
-	m_framebufferUpdateTimer.start( m_configuration.framebufferUpdateInterval() );
+	// relays subscribe to the message stream via the control connection of the
+	// multicast server - relays themselves never send to the multicast group
+	if( isRelay() || m_configuration.multicastEnabled() || m_configuration.relayFanOut() > 0 )
+	{
+		QHostAddress groupAddress;
+		if( isRelay() == false && m_configuration.multicastEnabled() )
+		{
+			groupAddress = QHostAddress( m_configuration.multicastGroupAddress() );
+		}
 
-	reconnectToVncServer();
+		m_multicastServer = new DemoMulticastServer( this, m_demoAccessToken, groupAddress,
+													 m_configuration.multicastPort(), this );
+	}
+
+	if( m_configuration.multithreadingEnabled() )
+	{
+		startConnectionThreads();
+	}
 }
 
 
@@ -72,14 +171,23 @@ DemoServer::~DemoServer()
 	m_vncServerSocket->disconnect( this );
 	m_tcpServer->disconnect( this );
 
+	if( m_upstreamSocket )
+	{
+		m_upstreamSocket->disconnect( this );
+	}
+
 	qDebug() << Q_FUNC_INFO << "deleting connections";
 
+	stopConnectionThreads();
+
 	QList<DemoServerConnection *> l;
 	while( !( l = findChildren<DemoServerConnection *>() ).isEmpty() )
 	{
 		delete l.front();
 	}
 
+	delete m_multicastServer;
+
 	qDebug() << Q_FUNC_INFO << "deleting server socket";
 	delete m_vncServerSocket;
 
@@ -93,14 +201,34 @@ DemoServer::~DemoServer()
 
 void DemoServer::acceptPendingConnections()
 {
-	if( m_vncClientProtocol.state() != VncClientProtocol::Running )
+	if( isRunning() == false )
 	{
 		return;
 	}
 
 	while( m_tcpServer->hasPendingConnections() )
 	{
-		new DemoServerConnection( m_demoAccessToken, m_tcpServer->nextPendingConnection(), this );
+		auto socket = m_tcpServer->nextPendingConnection();
+
+		if( m_connectionThreads.isEmpty() )
+		{
+			new DemoServerConnection( m_demoAccessToken, socket, this, this );
+			continue;
+		}
+
+		// hand connection over to next connection thread - objects to be moved
+		// must not have a parent outside the target thread
+		auto connection = new DemoServerConnection( m_demoAccessToken, socket, this, nullptr );
+		socket->setParent( connection );
+
+		auto thread = m_connectionThreads[m_nextConnectionThread];
+
+		// finished() is emitted within the thread right before it processes all
+		// pending deferred deletions so no connection survives its thread
+		connect( thread, &QThread::finished, connection, &DemoServerConnection::deleteLater );
+
+		connection->moveToThread( thread );
+		m_nextConnectionThread = ( m_nextConnectionThread + 1 ) % m_connectionThreads.size();
 	}
 }
 
@@ -145,11 +273,11 @@ void DemoServer::requestFramebufferUpdate()
 		return;
 	}
 
-	if( m_requestFullFramebufferUpdate ||
-			m_lastFullFramebufferUpdate.elapsed() >= m_configuration.keyFrameInterval() * 1000 )
+	// full updates are only needed for (re)building our decoded framebuffer - new
+	// or lagging clients are served with key frames generated from it
+	if( m_requestFullFramebufferUpdate )
 	{
 		m_vncClientProtocol.requestFramebufferUpdate( false );
-		m_lastFullFramebufferUpdate.restart();
 		m_requestFullFramebufferUpdate = false;
 	}
 	else
@@ -160,6 +288,80 @@ void DemoServer::requestFramebufferUpdate()
 
 
 
+void DemoServer::connectToUpstreamServer()
+{
+	if( m_upstreamSocket->state() == QAbstractSocket::UnconnectedState )
+	{
+		m_upstreamSocket->connectToHost( m_upstreamHost, static_cast<quint16>( m_configuration.multicastPort() ) );
+	}
+}
+
+
+
+void DemoServer::readFromUpstreamServer()
+{
+	VariantArrayMessage message( m_upstreamSocket );
+
+	while( message.isReadyForReceive() )
+	{
+		if( message.receive() == false || processUpstreamMessage( message ) == false )
+		{
+			m_upstreamSocket->close();
+			return;
+		}
+	}
+}
+
+
+
+bool DemoServer::isRunning() const
+{
+	if( isRelay() )
+	{
+		return m_serverInitMessage.isEmpty() == false;
+	}
+
+	return m_vncClientProtocol.state() == VncClientProtocol::Running;
+}
+
+
+
+void DemoServer::startConnectionThreads()
+{
+	const int threadCount = qMax( 1, QThread::idealThreadCount() );
+
+	m_connectionThreads.reserve( threadCount );
+
+	for( int i = 0; i < threadCount; ++i )
+	{
+		auto thread = new QThread( this );
+		thread->setObjectName( QStringLiteral( "DemoServerConnectionThread%1" ).arg( i ) );
+		thread->start();
+
+		m_connectionThreads.append( thread );
+	}
+
+	qDebug() << "DemoServer: serving clients in" << threadCount << "threads";
+}
+
+
+
+void DemoServer::stopConnectionThreads()
+{
+	// remaining connections get deleted in their threads while these finish
+	// and therefore before we return and any member they access goes away
+	for( auto thread : qAsConst( m_connectionThreads ) )
+	{
+		thread->quit();
+		thread->wait();
+		delete thread;
+	}
+
+	m_connectionThreads.clear();
+}
+
+
+
 bool DemoServer::receiveVncServerMessage()
 {
 	if( m_vncClientProtocol.receiveMessage() )
@@ -195,44 +397,450 @@ void DemoServer::enqueueFramebufferUpdateMessage( const QByteArray& message )
 
 	m_dataLock.lockForWrite();
 
-	if( isFullUpdate || framebufferUpdateMessageQueueSize() > m_configuration.memoryLimit()*2*1024*1024  )
+	if( decodeFramebufferUpdate( message ) )
 	{
-		if( m_keyFrameTimer.elapsed() > 1 )
+		if( isFullUpdate )
 		{
-			const auto memTotal = framebufferUpdateMessageQueueSize() / 1024;
-			qDebug() << Q_FUNC_INFO
-					 << "   MEMTOTAL:" << memTotal
-					 << "   KB/s:" << ( memTotal * 1000 ) / m_keyFrameTimer.elapsed();
+			m_framebufferValid = true;
+			m_requestFullFramebufferUpdate = false;
 		}
-		m_keyFrameTimer.restart();
-		++m_keyFrame;
-		m_framebufferUpdateMessages.clear();
 	}
+	else if( m_framebufferValid )
+	{
+		qWarning( "DemoServer: could not decode framebuffer update - requesting full update" );
+		m_framebufferValid = false;
+		m_requestFullFramebufferUpdate = true;
+	}
+
+	// wait for full update if we could not decode all updates
+	if( m_framebufferValid == false )
+	{
+		m_dataLock.unlock();
+		return;
+	}
+
+	const auto updatedRegion = m_updatedRegion;
+	const auto framebufferResized = m_framebufferResized;
 
-	m_framebufferUpdateMessages.append( message );
+	m_updatedRegion = QRegion();
+	m_framebufferResized = false;
 
 	m_dataLock.unlock();
 
-	// we're about to reach memory limits?
-	if( framebufferUpdateMessageQueueSize() > m_configuration.memoryLimit() * 1024 * 1024 )
+	// re-encode updated parts of framebuffer once for all clients - only tiles
+	// whose contents actually changed are included; the framebuffer is accessed
+	// by this thread only so connections can keep generating key frames meanwhile
+	const auto encodedTiles = m_tileEncoder.encodeChangedTiles( m_framebuffer, updatedRegion );
+
+	m_dataLock.lockForWrite();
+
+	const auto updateMessage = m_tileEncoder.applyEncodedTiles( encodedTiles, m_framebuffer.size(), framebufferResized );
+
+	if( updateMessage.isEmpty() )
 	{
-		// then request a full update so we can clear our queue
-		m_requestFullFramebufferUpdate = true;
+		m_dataLock.unlock();
+		return;
+	}
+
+	const auto sequence = queueFramebufferUpdateMessage( updateMessage );
+
+	m_dataLock.unlock();
+
+	if( m_multicastServer )
+	{
+		m_multicastServer->sendMessage( sequence, updateMessage );
 	}
 }
 
 
 
-qint64 DemoServer::framebufferUpdateMessageQueueSize() const
+qint64 DemoServer::queueFramebufferUpdateMessage( const QByteArray& message )
 {
-	qint64 size = 0;
+	// lagging clients do not need the queued messages any longer once
+	// they are too old as they can be served with a key frame instead
+	if( m_keyFrameTimer.elapsed() >= m_configuration.keyFrameInterval() * 1000 )
+	{
+		discardFramebufferUpdateMessages();
+	}
+
+	m_framebufferUpdateMessages.enqueue( message );
+
+	const auto sequence = m_framebufferUpdateMessages.endSequence() - 1;
 
-	for( const auto& message : qAsConst( m_framebufferUpdateMessages ) )
+	// evict oldest messages when exceeding memory limit
+	const qint64 memoryLimit = m_configuration.memoryLimit() * 1024 * 1024;
+
+	while( m_framebufferUpdateMessages.size() > memoryLimit && m_framebufferUpdateMessages.count() > 1 )
+	{
+		m_framebufferUpdateMessages.dequeue();
+	}
+
+	return sequence;
+}
+
+
+
+void DemoServer::discardFramebufferUpdateMessages()
+{
+	if( m_keyFrameTimer.elapsed() > 1 )
 	{
-		size += message.size();
+		const auto memTotal = m_framebufferUpdateMessages.size() / 1024;
+
+		qint64 maximumLag = 0;
+		qint64 skippedMessages = 0;
+		const auto statistics = connectionStatistics();
+		for( const auto& connectionStatistics : statistics )
+		{
+			maximumLag = qMax( maximumLag, connectionStatistics.messageLag );
+			skippedMessages += connectionStatistics.skippedMessages;
+		}
+
+		qDebug() << Q_FUNC_INFO
+				 << "   MEMTOTAL:" << memTotal
+				 << "   KB/s:" << ( memTotal * 1000 ) / m_keyFrameTimer.elapsed()
+				 << "   CLIENTS:" << statistics.size()
+				 << "   MAXLAG:" << maximumLag
+				 << "   SKIPPED:" << skippedMessages;
 	}
 
-	return size;
+	m_keyFrameTimer.restart();
+
+	m_framebufferUpdateMessages.clear();
+}
+
+
+
+QByteArray DemoServer::keyFrame( qint64* sequence, qint64 minimumSequence )
+{
+	// called by connections while holding the data lock for reading so
+	// the framebuffer and the message queue can't change meanwhile
+	QMutexLocker locker( &m_keyFrameLock );
+
+	if( m_keyFrameMessage.isEmpty() ||
+			m_keyFrameSequence < qMax( m_framebufferUpdateMessages.firstSequence(), minimumSequence ) )
+	{
+		if( m_framebufferValid == false )
+		{
+			return QByteArray();
+		}
+
+		m_keyFrameMessage = m_tileEncoder.encodeKeyFrame( m_tileEncoder.framebufferSize() != m_initialFramebufferSize );
+		m_keyFrameSequence = m_framebufferUpdateMessages.endSequence();
+	}
+
+	*sequence = m_keyFrameSequence;
+
+	return m_keyFrameMessage;
+}
+
+
+
+void DemoServer::updateConnectionStatistics( const QObject* connection, const ConnectionStatistics& statistics )
+{
+	QMutexLocker locker( &m_connectionStatisticsLock );
+	m_connectionStatistics[connection] = statistics;
+}
+
+
+
+void DemoServer::removeConnectionStatistics( const QObject* connection )
+{
+	QMutexLocker locker( &m_connectionStatisticsLock );
+	m_connectionStatistics.remove( connection );
+}
+
+
+
+DemoServer::ConnectionStatisticsMap DemoServer::connectionStatistics() const
+{
+	QMutexLocker locker( &m_connectionStatisticsLock );
+	return m_connectionStatistics;
+}
+
+
+
+bool DemoServer::processUpstreamMessage( VariantArrayMessage& message )
+{
+	const auto command = message.read().toInt();
+
+	switch( command )
+	{
+	case DemoMulticastServer::ServerInit:
+		return startRelaying( message.read().toByteArray() );
+
+	case DemoMulticastServer::KeyFrame:
+		message.read(); // sequence numbers of upstream server are not needed
+		return relayFramebufferUpdateMessage( message.read().toByteArray(), true );
+
+	case DemoMulticastServer::Message:
+		message.read();
+		return relayFramebufferUpdateMessage( message.read().toByteArray(), false );
+
+	default:
+		break;
+	}
+
+	qWarning() << "DemoServer: invalid message from upstream server" << command;
+
+	return false;
+}
+
+
+
+bool DemoServer::startRelaying( const QByteArray& serverInitMessage )
+{
+	if( serverInitMessage.size() < sz_rfbServerInitMsg )
+	{
+		return false;
+	}
+
+	rfbServerInitMsg serverInit;
+	memcpy( &serverInit, serverInitMessage.constData(), sz_rfbServerInitMsg );
+
+	const QSize framebufferSize( qFromBigEndian( serverInit.framebufferWidth ),
+								 qFromBigEndian( serverInit.framebufferHeight ) );
+
+	m_dataLock.lockForWrite();
+
+	// our clients keep the screen size they were initialized with
+	if( m_serverInitMessage.isEmpty() )
+	{
+		m_serverInitMessage = serverInitMessage;
+		m_initialFramebufferSize = framebufferSize;
+	}
+
+	// connected clients have to be informed if screen size changed while reconnecting
+	m_framebufferResized = m_tileEncoder.framebufferSize().isValid() &&
+			m_tileEncoder.framebufferSize() != framebufferSize;
+
+	m_framebufferValid = false;
+	m_tileEncoder.reset( framebufferSize );
+
+	m_dataLock.unlock();
+
+	// upstream server sends a key frame followed by all messages
+	VariantArrayMessage( m_upstreamSocket ).write( DemoMulticastServer::Subscribe ).send();
+
+	acceptPendingConnections();
+
+	return true;
+}
+
+
+
+bool DemoServer::relayFramebufferUpdateMessage( const QByteArray& message, bool isKeyFrame )
+{
+	m_dataLock.lockForWrite();
+
+	const auto framebufferSize = m_tileEncoder.framebufferSize();
+
+	if( m_tileEncoder.applyUpdate( message ) == false )
+	{
+		const auto framebufferWasValid = m_framebufferValid;
+		m_framebufferValid = false;
+		m_dataLock.unlock();
+
+		if( isKeyFrame )
+		{
+			// start over after reconnecting
+			qWarning( "DemoServer: could not apply key frame from upstream server" );
+			return false;
+		}
+
+		if( framebufferWasValid )
+		{
+			qWarning( "DemoServer: could not apply message from upstream server - requesting key frame" );
+			VariantArrayMessage( m_upstreamSocket ).write( DemoMulticastServer::RequestKeyFrame ).send();
+		}
+
+		return true;
+	}
+
+	if( isKeyFrame )
+	{
+		m_framebufferValid = true;
+	}
+
+	// wait for key frame if we could not apply all messages
+	if( m_framebufferValid == false )
+	{
+		m_dataLock.unlock();
+		return true;
+	}
+
+	auto updateMessage = message;
+
+	if( isKeyFrame )
+	{
+		// upstream key frames only announce screen size changes relative to
+		// the initial size of the upstream server so generate our own
+		updateMessage = m_tileEncoder.encodeKeyFrame( m_framebufferResized ||
+													  m_tileEncoder.framebufferSize() != framebufferSize );
+		m_framebufferResized = false;
+
+		if( updateMessage.isEmpty() )
+		{
+			m_framebufferValid = false;
+			m_dataLock.unlock();
+			qWarning( "DemoServer: incomplete key frame from upstream server" );
+			return false;
+		}
+	}
+
+	const auto sequence = queueFramebufferUpdateMessage( updateMessage );
+
+	m_dataLock.unlock();
+
+	m_multicastServer->sendMessage( sequence, updateMessage );
+
+	return true;
+}
+
+
+
+bool DemoServer::decodeFramebufferUpdate( const QByteArray& message )
+{
+	const char* data = message.constData();
+	const char* dataEnd = data + message.size();
+
+	if( message.size() < sz_rfbFramebufferUpdateMsg )
+	{
+		return false;
+	}
+
+	const auto updateMessage = reinterpret_cast<const rfbFramebufferUpdateMsg *>( data );
+	int rectCount = qFromBigEndian( updateMessage->nRects );
+	data += sz_rfbFramebufferUpdateMsg;
+
+	for( ; rectCount > 0; --rectCount )
+	{
+		if( dataEnd - data < sz_rfbFramebufferUpdateRectHeader )
+		{
+			return false;
+		}
+
+		rfbFramebufferUpdateRectHeader rectHeader;
+		memcpy( &rectHeader, data, sz_rfbFramebufferUpdateRectHeader );
+		data += sz_rfbFramebufferUpdateRectHeader;
+
+		const auto encoding = qFromBigEndian( rectHeader.encoding );
+		const QRect rect( qFromBigEndian( rectHeader.r.x ), qFromBigEndian( rectHeader.r.y ),
+						  qFromBigEndian( rectHeader.r.w ), qFromBigEndian( rectHeader.r.h ) );
+
+		switch( encoding )
+		{
+		case rfbEncodingLastRect:
+			return true;
+
+		case rfbEncodingNewFBSize:
+			m_framebuffer = QImage( rect.size(), QImage::Format_RGB32 );
+			m_framebufferValid = false;
+			m_framebufferResized = true;
+			m_updatedRegion = QRegion( m_framebuffer.rect() );
+			m_requestFullFramebufferUpdate = true;
+			break;
+
+		case rfbEncodingRaw:
+		{
+			const qint64 size = qint64( rect.width() ) * rect.height() * 4;
+			if( dataEnd - data < size || decodeRawRect( rect, data, size ) == false )
+			{
+				return false;
+			}
+			data += size;
+			break;
+		}
+
+		case rfbEncodingCopyRect:
+		{
+			if( dataEnd - data < sz_rfbCopyRect )
+			{
+				return false;
+			}
+
+			rfbCopyRect copyRect;
+			memcpy( &copyRect, data, sz_rfbCopyRect );
+			data += sz_rfbCopyRect;
+
+			const QRect sourceRect( qFromBigEndian( copyRect.srcX ), qFromBigEndian( copyRect.srcY ),
+									rect.width(), rect.height() );
+			if( m_framebuffer.rect().contains( sourceRect ) == false )
+			{
+				return false;
+			}
+
+			// copy source first as both areas may overlap
+			const auto source = m_framebuffer.copy( sourceRect );
+			if( decodeRawRect( rect, reinterpret_cast<const char *>( source.constBits() ),
+							   source.byteCount() ) == false )
+			{
+				return false;
+			}
+			break;
+		}
+
+		case rfbEncodingUltra:
+		{
+			if( dataEnd - data < sz_rfbZlibHeader )
+			{
+				return false;
+			}
+
+			rfbZlibHeader zlibHeader;
+			memcpy( &zlibHeader, data, sz_rfbZlibHeader );
+			data += sz_rfbZlibHeader;
+
+			const qint64 compressedSize = qFromBigEndian( zlibHeader.nBytes );
+			if( dataEnd - data < compressedSize )
+			{
+				return false;
+			}
+
+			QByteArray pixels( rect.width() * rect.height() * 4, Qt::Uninitialized );
+			lzo_uint pixelDataSize = pixels.size();
+
+			if( lzo1x_decompress_safe( reinterpret_cast<lzo_bytep>( const_cast<char *>( data ) ), compressedSize,
+									   reinterpret_cast<lzo_bytep>( pixels.data() ), &pixelDataSize,
+									   nullptr ) != LZO_E_OK ||
+					pixelDataSize != static_cast<lzo_uint>( pixels.size() ) ||
+					decodeRawRect( rect, pixels.constData(), pixels.size() ) == false )
+			{
+				return false;
+			}
+			data += compressedSize;
+			break;
+		}
+
+		default:
+			// encodings we can't decode should never be sent as we do not announce them
+			qWarning() << Q_FUNC_INFO << "unsupported rect encoding" << encoding;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+
+bool DemoServer::decodeRawRect( const QRect& rect, const char* data, qint64 size )
+{
+	if( m_framebuffer.rect().contains( rect ) == false ||
+			size < qint64( rect.width() ) * rect.height() * 4 )
+	{
+		return false;
+	}
+
+	const int lineSize = rect.width() * 4;
+
+	for( int y = 0; y < rect.height(); ++y )
+	{
+		memcpy( m_framebuffer.scanLine( rect.y() + y ) + rect.x() * 4, data + y * lineSize, lineSize );
+	}
+
+	m_updatedRegion += rect;
+
+	return true;
 }
 
 
@@ -242,6 +850,23 @@ void DemoServer::start()
 	setVncServerPixelFormat();
 	setVncServerEncodings();
 
+	m_dataLock.lockForWrite();
+
+	m_serverInitMessage = m_vncClientProtocol.serverInitMessage();
+
+	// rebuild decoded framebuffer from initial full update
+	m_initialFramebufferSize = QSize( m_vncClientProtocol.framebufferWidth(), m_vncClientProtocol.framebufferHeight() );
+
+	// connected clients have to be informed if screen size changed while reconnecting
+	m_framebufferResized = m_framebuffer.isNull() == false && m_framebuffer.size() != m_initialFramebufferSize;
+
+	m_framebuffer = QImage( m_initialFramebufferSize, QImage::Format_RGB32 );
+	m_framebufferValid = false;
+	m_updatedRegion = QRegion();
+	m_tileEncoder.reset( m_initialFramebufferSize );
+
+	m_dataLock.unlock();
+
 	m_requestFullFramebufferUpdate = true;
 
 	requestFramebufferUpdate();
@@ -277,14 +902,11 @@ bool DemoServer::setVncServerPixelFormat()
 
 bool DemoServer::setVncServerEncodings()
 {
+	// only announce encodings decodeFramebufferUpdate() can handle
 	return m_vncClientProtocol.
 			setEncodings( {
-							  rfbEncodingUltraZip,
 							  rfbEncodingUltra,
 							  rfbEncodingCopyRect,
-							  rfbEncodingHextile,
-							  rfbEncodingCoRRE,
-							  rfbEncodingRRE,
 							  rfbEncodingRaw,
 							  rfbEncodingCompressLevel9,
 							  rfbEncodingQualityLevel7,
@@ -27,22 +27,46 @@
 #define DEMO_SERVER_H
 
 #include <QElapsedTimer>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
 #include <QReadWriteLock>
+#include <QRegion>
 #include <QTimer>
 
+#include "DemoServerMessageQueue.h"
+#include "DemoServerTileEncoder.h"
 #include "VncClientProtocol.h"
 
 class DemoConfiguration;
+class DemoMulticastServer;
 class QTcpServer;
+class QThread;
+class VariantArrayMessage;
 
 class DemoServer : public QObject
 {
 	Q_OBJECT
 public:
-	typedef QVector<QByteArray> MessageList;
+	struct ConnectionStatistics
+	{
+		qint64 messageLag;			/**< number of queued messages not sent yet */
+		qint64 socketBacklog;		/**< bytes written but not yet sent to client */
+		int roundTripTime;			/**< smoothed time between sending an update and the next request in ms */
+		qint64 skippedMessages;		/**< messages skipped by resyncing with key frames */
+		int keyFrames;				/**< number of key frames sent */
+	} ;
+
+	typedef QHash<const QObject *, ConnectionStatistics> ConnectionStatisticsMap;
 
 	DemoServer( int vncServerPort, const QString& vncServerPassword, const QString& demoAccessToken,
 				const DemoConfiguration& configuration, QObject *parent );
+
+	// relay mode: re-serve the message stream of another demo server (or relay) received
+	// via its control connection instead of encoding the screen of a local VNC server -
+	// switches to the fallback host (if any) if the upstream host stays unreachable
+	DemoServer( const QString& upstreamHost, const QString& fallbackUpstreamHost, const QString& demoAccessToken,
+				const DemoConfiguration& configuration, QObject *parent );
 	~DemoServer() override;
 
 	const DemoConfiguration& configuration() const
@@ -52,7 +76,7 @@ public:
 
 	const QByteArray& serverInitMessage() const
 	{
-		return m_vncClientProtocol.serverInitMessage();
+		return m_serverInitMessage;
 	}
 
 	void lockDataForRead()
@@ -65,27 +89,55 @@ public:
 		m_dataLock.unlock();
 	}
 
-	int keyFrame() const
-	{
-		return m_keyFrame;
-	}
-
-	const MessageList& framebufferUpdateMessages() const
+	const DemoServerMessageQueue& framebufferUpdateMessages() const
 	{
 		return m_framebufferUpdateMessages;
 	}
 
+	QByteArray keyFrame( qint64* sequence, qint64 minimumSequence = 0 );
+
+	void updateConnectionStatistics( const QObject* connection, const ConnectionStatistics& statistics );
+	void removeConnectionStatistics( const QObject* connection );
+	ConnectionStatisticsMap connectionStatistics() const;
+
 private slots:
 	void acceptPendingConnections();
 	void reconnectToVncServer();
 	void readFromVncServer();
 	void requestFramebufferUpdate();
+	void connectToUpstreamServer();
+	void readFromUpstreamServer();
 
 private:
+	enum {
+		UpstreamReconnectInterval = 1000,
+		UpstreamFallbackAttempts = 5
+	};
+
+	DemoServer( int vncServerPort, const QString& vncServerPassword, const QString& upstreamHost,
+				const QString& demoAccessToken, const DemoConfiguration& configuration, QObject *parent );
+
+	bool isRelay() const
+	{
+		return m_upstreamHost.isEmpty() == false;
+	}
+
+	bool isRunning() const;
+
+	void startConnectionThreads();
+	void stopConnectionThreads();
+
 	bool receiveVncServerMessage();
 	void enqueueFramebufferUpdateMessage( const QByteArray& message );
+	qint64 queueFramebufferUpdateMessage( const QByteArray& message );
+	void discardFramebufferUpdateMessages();
 
-	qint64 framebufferUpdateMessageQueueSize() const;
+	bool processUpstreamMessage( VariantArrayMessage& message );
+	bool startRelaying( const QByteArray& serverInitMessage );
+	bool relayFramebufferUpdateMessage( const QByteArray& message, bool isKeyFrame );
+
+	bool decodeFramebufferUpdate( const QByteArray& message );
+	bool decodeRawRect( const QRect& rect, const char* data, qint64 size );
 
 	void start();
 	bool setVncServerPixelFormat();
@@ -93,20 +145,43 @@ private:
 
 	const DemoConfiguration& m_configuration;
 	const int m_vncServerPort;
+	QString m_upstreamHost;
+	QString m_fallbackUpstreamHost;
+	int m_failedUpstreamConnects;
 	const QString m_demoAccessToken;
 
 	QTcpServer* m_tcpServer;
+	DemoMulticastServer* m_multicastServer;
 	QTcpSocket* m_vncServerSocket;
 	VncClientProtocol m_vncClientProtocol;
+	QTcpSocket* m_upstreamSocket;
+	QByteArray m_serverInitMessage;
 
 	QReadWriteLock m_dataLock;
 	QTimer m_framebufferUpdateTimer;
-	QElapsedTimer m_lastFullFramebufferUpdate;
 	QElapsedTimer m_keyFrameTimer;
 	bool m_requestFullFramebufferUpdate;
 
-	int m_keyFrame;
-	MessageList m_framebufferUpdateMessages;
+	DemoServerMessageQueue m_framebufferUpdateMessages;
+
+	// decoded framebuffer which is re-encoded for all clients
+	QImage m_framebuffer;
+	bool m_framebufferValid;
+	bool m_framebufferResized;
+	QSize m_initialFramebufferSize;
+	QRegion m_updatedRegion;
+	DemoServerTileEncoder m_tileEncoder;
+
+	QMutex m_keyFrameLock;
+	QByteArray m_keyFrameMessage;
+	qint64 m_keyFrameSequence;
+
+	mutable QMutex m_connectionStatisticsLock;
+	ConnectionStatisticsMap m_connectionStatistics;
+
+	// client connections are spread across these threads if multithreading is enabled
+	QVector<QThread *> m_connectionThreads;
+	int m_nextConnectionThread;
 
 } ;
 
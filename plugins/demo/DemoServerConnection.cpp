@@ -32,8 +32,9 @@
 
 DemoServerConnection::DemoServerConnection( const QString& demoAccessToken,
 											QTcpSocket* socket,
-											DemoServer* demoServer ) :
-	QObject( demoServer ),
+											DemoServer* demoServer,
+											QObject* parent ) :
+	QObject( parent ),
 	m_demoServer( demoServer ),
 	m_socket( socket ),
 	m_vncServerClient(),
@@ -44,8 +45,11 @@ DemoServerConnection::DemoServerConnection( const QString& demoAccessToken,
 									 std::pair<int, int>( rfbKeyEvent, sz_rfbKeyEventMsg ),
 									 std::pair<int, int>( rfbPointerEvent, sz_rfbPointerEventMsg ),
 									 } ),
-	m_keyFrame( -1 ),
-	m_framebufferUpdateMessageIndex( 0 ),
+	m_nextMessageSequence( -1 ),
+	m_updateSentTimer(),
+	m_roundTripTime( -1 ),
+	m_skippedMessages( 0 ),
+	m_keyFrameCount( 0 ),
 	m_framebufferUpdateInterval( m_demoServer->configuration().framebufferUpdateInterval() )
 {
 	connect( m_socket, &QTcpSocket::readyRead, this, &DemoServerConnection::processClient );
@@ -59,6 +63,8 @@ DemoServerConnection::DemoServerConnection( const QString& demoAccessToken,
 
 DemoServerConnection::~DemoServerConnection()
 {
+	m_demoServer->removeConnectionStatistics( this );
+
 	delete m_socket;
 }
 
@@ -130,6 +136,7 @@ bool DemoServerConnection::receiveClientMessage()
 
 		if( messageType == rfbFramebufferUpdateRequest )
 		{
+			updateRoundTripTime();
 			sendFramebufferUpdate();
 		}
 
@@ -147,27 +154,137 @@ void DemoServerConnection::sendFramebufferUpdate()
 
 	const auto& framebufferUpdateMessages = m_demoServer->framebufferUpdateMessages();
 
-	const int framebufferUpdateMessageCount = framebufferUpdateMessages.count();
+	const qint64 firstMessageSequence = framebufferUpdateMessages.firstSequence();
+	const qint64 endMessageSequence = framebufferUpdateMessages.endSequence();
 
-	if( m_demoServer->keyFrame() != m_keyFrame ||
-			m_framebufferUpdateMessageIndex > framebufferUpdateMessageCount )
+	// client does not keep up with the data written so far? then do not grow
+	// the backlog any further but let messages pile up in the queue instead
+	if( m_socket->bytesToWrite() > MaximumBacklogSize )
 	{
-		m_framebufferUpdateMessageIndex = 0;
-		m_keyFrame = m_demoServer->keyFrame();
+		updateStatistics( endMessageSequence );
+
+		m_demoServer->unlockData();
+
+		QTimer::singleShot( qMax( m_framebufferUpdateInterval, m_roundTripTime / 2 ),
+							this, &DemoServerConnection::sendFramebufferUpdate );
+		return;
 	}
 
 	bool sentUpdates = false;
-	for( ; m_framebufferUpdateMessageIndex < framebufferUpdateMessageCount; ++m_framebufferUpdateMessageIndex )
+
+	// new client or messages required by us have been discarded already?
+	if( m_nextMessageSequence < firstMessageSequence )
+	{
+		sentUpdates = resyncWithKeyFrame( 0 );
+	}
+	else if( pendingMessagesSize() > MaximumBacklogSize )
+	{
+		// client fell behind so skip intermediate updates if a key frame is cheaper
+		sentUpdates = resyncWithKeyFrame( m_nextMessageSequence + 1 );
+	}
+
+	if( m_nextMessageSequence >= firstMessageSequence )
 	{
-		m_socket->write( framebufferUpdateMessages[m_framebufferUpdateMessageIndex] );
-		sentUpdates = true;
+		for( ; m_nextMessageSequence < endMessageSequence; ++m_nextMessageSequence )
+		{
+			m_socket->write( framebufferUpdateMessages.message( m_nextMessageSequence ) );
+			sentUpdates = true;
+		}
 	}
 
+	updateStatistics( endMessageSequence );
+
 	m_demoServer->unlockData();
 
-	if( sentUpdates == false )
+	if( sentUpdates )
+	{
+		if( m_updateSentTimer.isValid() == false )
+		{
+			m_updateSentTimer.start();
+		}
+	}
+	else
 	{
 		// did not send updates but client still waiting for update? then try again soon
 		QTimer::singleShot( m_framebufferUpdateInterval, this, &DemoServerConnection::sendFramebufferUpdate );
 	}
 }
+
+
+
+void DemoServerConnection::updateRoundTripTime()
+{
+	if( m_updateSentTimer.isValid() == false )
+	{
+		return;
+	}
+
+	const auto roundTripTime = static_cast<int>( m_updateSentTimer.elapsed() );
+
+	if( m_roundTripTime < 0 )
+	{
+		m_roundTripTime = roundTripTime;
+	}
+	else
+	{
+		m_roundTripTime = ( m_roundTripTime * 7 + roundTripTime ) / 8;
+	}
+
+	m_updateSentTimer.invalidate();
+}
+
+
+
+void DemoServerConnection::updateStatistics( qint64 endMessageSequence )
+{
+	DemoServer::ConnectionStatistics statistics;
+	statistics.messageLag = endMessageSequence - qMax( m_nextMessageSequence,
+													   m_demoServer->framebufferUpdateMessages().firstSequence() );
+	statistics.socketBacklog = m_socket->bytesToWrite();
+	statistics.roundTripTime = m_roundTripTime;
+	statistics.skippedMessages = m_skippedMessages;
+	statistics.keyFrames = m_keyFrameCount;
+
+	m_demoServer->updateConnectionStatistics( this, statistics );
+}
+
+
+
+bool DemoServerConnection::resyncWithKeyFrame( qint64 minimumSequence )
+{
+	qint64 keyFrameSequence = 0;
+	const auto keyFrame = m_demoServer->keyFrame( &keyFrameSequence, minimumSequence );
+
+	if( keyFrame.isEmpty() )
+	{
+		return false;
+	}
+
+	if( m_nextMessageSequence >= m_demoServer->framebufferUpdateMessages().firstSequence() )
+	{
+		// only skip if the key frame actually saves bandwidth
+		if( keyFrameSequence <= m_nextMessageSequence ||
+				pendingMessagesSize() <= keyFrame.size() )
+		{
+			return false;
+		}
+	}
+
+	if( m_nextMessageSequence >= 0 )
+	{
+		m_skippedMessages += keyFrameSequence - m_nextMessageSequence;
+	}
+
+	m_socket->write( keyFrame );
+	m_nextMessageSequence = keyFrameSequence;
+	++m_keyFrameCount;
+
+	return true;
+}
+
+
+
+qint64 DemoServerConnection::pendingMessagesSize() const
+{
+	return m_demoServer->framebufferUpdateMessages().sizeFrom( m_nextMessageSequence );
+}
@@ -25,24 +25,27 @@
 #ifndef DEMO_SERVER_CONNECTION_H
 #define DEMO_SERVER_CONNECTION_H
 
+#include <QElapsedTimer>
+
 #include "DemoServerProtocol.h"
 
 class DemoServer;
 
 // clazy:excludeall=ctor-missing-parent-argument
 
-// the demo server creates an instance of this class for each client connection,
-// i.e. each client is connected to a different server thread for best
-// performance
+// the demo server creates an instance of this class for each client connection -
+// if multithreading is enabled, instances are spread across several threads
+// which read the shared framebuffer update messages concurrently
 class DemoServerConnection : public QObject
 {
 	Q_OBJECT
 public:
 	enum {
 		ProtocolRetryTime = 250,
+		MaximumBacklogSize = 1024*1024,	/**< bytes to buffer for slow clients before skipping messages */
 	};
 
-	DemoServerConnection( const QString& demoAccessToken, QTcpSocket* socket, DemoServer* demoServer );
+	DemoServerConnection( const QString& demoAccessToken, QTcpSocket* socket, DemoServer* demoServer, QObject* parent );
 	~DemoServerConnection() override;
 
 public slots:
@@ -51,6 +54,11 @@ public slots:
 
 private:
 	bool receiveClientMessage();
+	void updateRoundTripTime();
+	void updateStatistics( qint64 endMessageSequence );
+
+	bool resyncWithKeyFrame( qint64 minimumSequence );
+	qint64 pendingMessagesSize() const;
 
 	DemoServer* m_demoServer;
 
@@ -61,8 +69,13 @@ private:
 
 	const QMap<int, int> m_rfbClientToServerMessageSizes;
 
-	int m_keyFrame;
-	int m_framebufferUpdateMessageIndex;
+	// sequence number of next framebuffer update message to send
+	qint64 m_nextMessageSequence;
+
+	QElapsedTimer m_updateSentTimer;
+	int m_roundTripTime;
+	qint64 m_skippedMessages;
+	int m_keyFrameCount;
 
 	const int m_framebufferUpdateInterval;
 
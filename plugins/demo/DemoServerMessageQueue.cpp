@@ -0,0 +1,116 @@
+/*
+ * DemoServerMessageQueue.cpp - implementation of DemoServerMessageQueue class
+ *
+ * Copyright (c) 2017 Tobias Junghans <tobydox@users.sf.net>
+ *
+ * This file is part of Veyon - http://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include "DemoServerMessageQueue.h"
+
+
+DemoServerMessageQueue::DemoServerMessageQueue() :
+	m_entries( InitialCapacity ),
+	m_head( 0 ),
+	m_count( 0 ),
+	m_firstSequence( 0 ),
+	m_size( 0 ),
+	m_totalSize( 0 )
+{
+}
+
+
+
+qint64 DemoServerMessageQueue::sizeFrom( qint64 sequence ) const
+{
+	if( sequence <= m_firstSequence )
+	{
+		return m_size;
+	}
+
+	if( sequence >= endSequence() )
+	{
+		return 0;
+	}
+
+	return m_totalSize - m_entries[index( sequence )].offset;
+}
+
+
+
+void DemoServerMessageQueue::enqueue( const QByteArray& message )
+{
+	if( m_count >= m_entries.size() )
+	{
+		grow();
+	}
+
+	auto& entry = m_entries[index( endSequence() )];
+	entry.message = message;
+	entry.offset = m_totalSize;
+
+	++m_count;
+	m_size += message.size();
+	m_totalSize += message.size();
+}
+
+
+
+void DemoServerMessageQueue::dequeue()
+{
+	if( m_count <= 0 )
+	{
+		return;
+	}
+
+	auto& entry = m_entries[m_head];
+	m_size -= entry.message.size();
+	entry.message = QByteArray();
+
+	m_head = ( m_head + 1 ) & ( m_entries.size() - 1 );
+	--m_count;
+	++m_firstSequence;
+}
+
+
+
+void DemoServerMessageQueue::clear()
+{
+	while( m_count > 0 )
+	{
+		dequeue();
+	}
+
+	m_head = 0;
+}
+
+
+
+void DemoServerMessageQueue::grow()
+{
+	QVector<Entry> entries( m_entries.size() * 2 );
+
+	for( int i = 0; i < m_count; ++i )
+	{
+		entries[i] = m_entries[index( m_firstSequence + i )];
+	}
+
+	m_entries.swap( entries );
+	m_head = 0;
+}
@@ -0,0 +1,106 @@
+/*
+ * DemoServerMessageQueue.h - header file for DemoServerMessageQueue class
+ *
+ * Copyright (c) 2017 Tobias Junghans <tobydox@users.sf.net>
+ *
+ * This file is part of Veyon - http://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef DEMO_SERVER_MESSAGE_QUEUE_H
+#define DEMO_SERVER_MESSAGE_QUEUE_H
+
+#include <QByteArray>
+#include <QVector>
+
+// ring buffer of framebuffer update messages - each message is identified by
+// a stable sequence number so readers can keep a cursor across evictions,
+// and the size of all or remaining messages is available in constant time
+class DemoServerMessageQueue
+{
+public:
+	DemoServerMessageQueue();
+
+	// sequence number of oldest queued message
+	qint64 firstSequence() const
+	{
+		return m_firstSequence;
+	}
+
+	// sequence number the next enqueued message will get
+	qint64 endSequence() const
+	{
+		return m_firstSequence + m_count;
+	}
+
+	int count() const
+	{
+		return m_count;
+	}
+
+	bool isEmpty() const
+	{
+		return m_count == 0;
+	}
+
+	// total size of all queued messages in bytes
+	qint64 size() const
+	{
+		return m_size;
+	}
+
+	const QByteArray& message( qint64 sequence ) const
+	{
+		return m_entries[index( sequence )].message;
+	}
+
+	qint64 sizeFrom( qint64 sequence ) const;
+
+	void enqueue( const QByteArray& message );
+	void dequeue();
+	void clear();
+
+private:
+	enum {
+		InitialCapacity = 64
+	};
+
+	struct Entry
+	{
+		QByteArray message;
+		qint64 offset;		/**< total size of all messages enqueued before */
+	} ;
+
+	int index( qint64 sequence ) const
+	{
+		// capacity is always a power of two
+		return ( m_head + static_cast<int>( sequence - m_firstSequence ) ) & ( m_entries.size() - 1 );
+	}
+
+	void grow();
+
+	QVector<Entry> m_entries;
+	int m_head;
+	int m_count;
+	qint64 m_firstSequence;
+	qint64 m_size;
+	qint64 m_totalSize;
+
+} ;
+
+#endif
@@ -0,0 +1,453 @@
+/*
+ * DemoServerTileEncoder.cpp - implementation of DemoServerTileEncoder class
+ *
+ * Copyright (c) 2017 Tobias Junghans <tobydox@users.sf.net>
+ *
+ * This file is part of Veyon - http://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include <QtEndian>
+
+#include <zlib.h>
+
+#include "DemoServerTileEncoder.h"
+#include "VncClientProtocol.h"
+
+
+DemoServerTileEncoder::DemoServerTileEncoder() :
+	m_framebufferSize(),
+	m_columns( 0 ),
+	m_rows( 0 ),
+	m_tiles(),
+	m_encodingCache(),
+	m_pixelBuffer(),
+	m_compressionBuffer()
+{
+}
+
+
+
+void DemoServerTileEncoder::reset( const QSize& framebufferSize )
+{
+	m_framebufferSize = framebufferSize;
+	m_columns = ( framebufferSize.width() + TileSize - 1 ) / TileSize;
+	m_rows = ( framebufferSize.height() + TileSize - 1 ) / TileSize;
+
+	m_tiles.fill( Tile { 0, false, QByteArray() }, m_columns * m_rows );
+	m_encodingCache.clear();
+}
+
+
+
+DemoServerTileEncoder::EncodedTiles DemoServerTileEncoder::encodeChangedTiles( const QImage& framebuffer, const QRegion& region )
+{
+	// all tiles have to be encoded if the framebuffer has been resized
+	const bool compareTiles = framebuffer.size() == m_framebufferSize;
+	const int columns = ( framebuffer.width() + TileSize - 1 ) / TileSize;
+	const int rows = ( framebuffer.height() + TileSize - 1 ) / TileSize;
+
+	EncodedTiles encodedTiles;
+
+	// tiles touched by several rects of the region are only checked once
+	QVector<bool> checkedTiles( columns * rows, false );
+
+	for( const auto& regionRect : region.intersected( framebuffer.rect() ).rects() )
+	{
+		for( int row = regionRect.top() / TileSize; row <= regionRect.bottom() / TileSize; ++row )
+		{
+			for( int column = regionRect.left() / TileSize; column <= regionRect.right() / TileSize; ++column )
+			{
+				const int index = row * columns + column;
+				if( checkedTiles[index] )
+				{
+					continue;
+				}
+				checkedTiles[index] = true;
+
+				const auto rect = QRect( column * TileSize, row * TileSize, TileSize, TileSize ).intersected( framebuffer.rect() );
+				const auto hash = tileHash( framebuffer, rect );
+
+				if( compareTiles && m_tiles[index].valid && m_tiles[index].hash == hash )
+				{
+					// upstream sent unchanged contents
+					continue;
+				}
+
+				auto tightData = m_encodingCache.value( hash );
+				if( tightData.isEmpty() )
+				{
+					tightData = encodeTile( framebuffer, rect );
+					if( tightData.isEmpty() )
+					{
+						continue;
+					}
+
+					if( m_encodingCache.size() >= MaximumCachedEncodings )
+					{
+						m_encodingCache.clear();
+					}
+					m_encodingCache.insert( hash, tightData );
+				}
+
+				encodedTiles.append( EncodedTile { index, hash, rect, tightData } );
+			}
+		}
+	}
+
+	return encodedTiles;
+}
+
+
+
+QByteArray DemoServerTileEncoder::applyEncodedTiles( const EncodedTiles& tiles, const QSize& framebufferSize, bool announceSize )
+{
+	if( framebufferSize != m_framebufferSize )
+	{
+		reset( framebufferSize );
+	}
+
+	if( tiles.isEmpty() && announceSize == false )
+	{
+		return QByteArray();
+	}
+
+	int size = sz_rfbFramebufferUpdateMsg + sz_rfbFramebufferUpdateRectHeader;
+	for( const auto& encodedTile : tiles )
+	{
+		size += sz_rfbFramebufferUpdateRectHeader + encodedTile.tightData.size();
+	}
+
+	QByteArray message;
+	message.reserve( size );
+
+	appendUpdateMessageHeader( message, tiles.size() + ( announceSize ? 1 : 0 ) );
+
+	if( announceSize )
+	{
+		appendRectHeader( message, QRect( QPoint( 0, 0 ), framebufferSize ), rfbEncodingNewFBSize );
+	}
+
+	for( const auto& encodedTile : tiles )
+	{
+		auto& tile = m_tiles[encodedTile.index];
+		tile.hash = encodedTile.hash;
+		tile.valid = true;
+		tile.encoding.clear();
+		appendRectHeader( tile.encoding, encodedTile.rect, rfbEncodingTight );
+		tile.encoding.append( encodedTile.tightData );
+
+		message.append( tile.encoding );
+	}
+
+	return message;
+}
+
+
+
+QByteArray DemoServerTileEncoder::encodeKeyFrame( bool announceSize ) const
+{
+	int size = sz_rfbFramebufferUpdateMsg + sz_rfbFramebufferUpdateRectHeader;
+	for( const auto& tile : m_tiles )
+	{
+		if( tile.valid == false )
+		{
+			return QByteArray();
+		}
+		size += tile.encoding.size();
+	}
+
+	QByteArray message;
+	message.reserve( size );
+
+	appendUpdateMessageHeader( message, m_tiles.size() + ( announceSize ? 1 : 0 ) );
+
+	if( announceSize )
+	{
+		appendRectHeader( message, QRect( QPoint( 0, 0 ), m_framebufferSize ), rfbEncodingNewFBSize );
+	}
+
+	// no need to compress anything again as all tiles already are encoded
+	for( const auto& tile : m_tiles )
+	{
+		message.append( tile.encoding );
+	}
+
+	return message;
+}
+
+
+
+bool DemoServerTileEncoder::applyUpdate( const QByteArray& message )
+{
+	const char* data = message.constData();
+	const char* dataEnd = data + message.size();
+
+	if( message.size() < sz_rfbFramebufferUpdateMsg )
+	{
+		return false;
+	}
+
+	const auto updateMessage = reinterpret_cast<const rfbFramebufferUpdateMsg *>( data );
+	int rectCount = qFromBigEndian( updateMessage->nRects );
+	data += sz_rfbFramebufferUpdateMsg;
+
+	for( ; rectCount > 0; --rectCount )
+	{
+		if( dataEnd - data < sz_rfbFramebufferUpdateRectHeader )
+		{
+			return false;
+		}
+
+		rfbFramebufferUpdateRectHeader rectHeader;
+		memcpy( &rectHeader, data, sz_rfbFramebufferUpdateRectHeader );
+
+		const auto encoding = qFromBigEndian( rectHeader.encoding );
+		const QRect rect( qFromBigEndian( rectHeader.r.x ), qFromBigEndian( rectHeader.r.y ),
+						  qFromBigEndian( rectHeader.r.w ), qFromBigEndian( rectHeader.r.h ) );
+
+		if( encoding == rfbEncodingNewFBSize )
+		{
+			reset( rect.size() );
+			data += sz_rfbFramebufferUpdateRectHeader;
+			continue;
+		}
+
+		const int column = rect.x() / TileSize;
+		const int row = rect.y() / TileSize;
+
+		// we only understand what applyEncodedTiles() generates
+		if( encoding != static_cast<int>( rfbEncodingTight ) ||
+				rect.x() % TileSize || rect.y() % TileSize ||
+				column >= m_columns || row >= m_rows )
+		{
+			return false;
+		}
+
+		const auto tightSize = tightDataSize( data + sz_rfbFramebufferUpdateRectHeader,
+											  dataEnd - data - sz_rfbFramebufferUpdateRectHeader, rect );
+		if( tightSize <= 0 )
+		{
+			return false;
+		}
+
+		auto& tile = m_tiles[row * m_columns + column];
+		tile.encoding = QByteArray( data, sz_rfbFramebufferUpdateRectHeader + tightSize );
+		tile.valid = true;
+		tile.hash = 0;
+
+		data += sz_rfbFramebufferUpdateRectHeader + tightSize;
+	}
+
+	return true;
+}
+
+
+
+int DemoServerTileEncoder::tightDataSize( const char* data, qint64 size, const QRect& rect )
+{
+	if( size < 1 )
+	{
+		return -1;
+	}
+
+	const auto control = static_cast<uchar>( data[0] );
+
+	if( control == ( rfbTightFill << 4 ) )
+	{
+		return size >= 4 ? 4 : -1;
+	}
+
+	// basic compression with copy filter and 24 bit pixels only
+	if( ( control >> 4 ) != 0 )
+	{
+		return -1;
+	}
+
+	const int pixelDataSize = rect.width() * rect.height() * 3;
+	if( pixelDataSize < MinimumCompressedSize )
+	{
+		return size >= 1 + pixelDataSize ? 1 + pixelDataSize : -1;
+	}
+
+	int length = 0;
+	int lengthSize = 0;
+	for( int shift = 0; lengthSize < 3; shift += 7 )
+	{
+		if( 1 + lengthSize >= size )
+		{
+			return -1;
+		}
+
+		const auto byte = static_cast<uchar>( data[1 + lengthSize] );
+		++lengthSize;
+
+		if( lengthSize < 3 )
+		{
+			length |= ( byte & 0x7f ) << shift;
+			if( ( byte & 0x80 ) == 0 )
+			{
+				break;
+			}
+		}
+		else
+		{
+			length |= byte << shift;
+		}
+	}
+
+	const qint64 totalSize = 1 + lengthSize + length;
+
+	return size >= totalSize ? static_cast<int>( totalSize ) : -1;
+}
+
+
+
+quint64 DemoServerTileEncoder::tileHash( const QImage& framebuffer, const QRect& rect )
+{
+	// 64 bit FNV-1a processing whole pixels, seeded with the tile size as tiles
+	// at the right and bottom edges may be smaller
+	const quint64 prime = Q_UINT64_C(1099511628211);
+	quint64 hash = Q_UINT64_C(14695981039346656037) ^ ( quint64( rect.width() ) << 32 | quint64( rect.height() ) );
+
+	for( int y = rect.top(); y <= rect.bottom(); ++y )
+	{
+		const auto pixels = reinterpret_cast<const quint32 *>( framebuffer.constScanLine( y ) ) + rect.left();
+		for( int x = 0; x < rect.width(); ++x )
+		{
+			hash = ( hash ^ pixels[x] ) * prime;
+		}
+	}
+
+	return hash;
+}
+
+
+
+QByteArray DemoServerTileEncoder::encodeTile( const QImage& framebuffer, const QRect& rect )
+{
+	QByteArray encoding;
+
+	const auto firstPixel = reinterpret_cast<const QRgb *>( framebuffer.constScanLine( rect.top() ) )[rect.left()];
+
+	bool solid = true;
+	for( int y = rect.top(); y <= rect.bottom() && solid; ++y )
+	{
+		const auto pixels = reinterpret_cast<const QRgb *>( framebuffer.constScanLine( y ) ) + rect.left();
+		for( int x = 0; x < rect.width(); ++x )
+		{
+			if( pixels[x] != firstPixel )
+			{
+				solid = false;
+				break;
+			}
+		}
+	}
+
+	// pixels are transferred as 24 bit RGB values (TPIXEL) as clients use a depth of 24
+	if( solid )
+	{
+		encoding.append( char( rfbTightFill << 4 ) );
+		encoding.append( char( qRed( firstPixel ) ) );
+		encoding.append( char( qGreen( firstPixel ) ) );
+		encoding.append( char( qBlue( firstPixel ) ) );
+		return encoding;
+	}
+
+	m_pixelBuffer.resize( rect.width() * rect.height() * 3 );
+	auto out = reinterpret_cast<uchar *>( m_pixelBuffer.data() );
+
+	for( int y = rect.top(); y <= rect.bottom(); ++y )
+	{
+		const auto pixels = reinterpret_cast<const QRgb *>( framebuffer.constScanLine( y ) ) + rect.left();
+		for( int x = 0; x < rect.width(); ++x )
+		{
+			*out++ = static_cast<uchar>( qRed( pixels[x] ) );
+			*out++ = static_cast<uchar>( qGreen( pixels[x] ) );
+			*out++ = static_cast<uchar>( qBlue( pixels[x] ) );
+		}
+	}
+
+	// basic compression with copy filter, resetting zlib stream 0 so the
+	// tile can be decoded regardless of what the client received before
+	encoding.append( char( 0x01 ) );
+
+	if( m_pixelBuffer.size() < MinimumCompressedSize )
+	{
+		encoding.append( m_pixelBuffer );
+		return encoding;
+	}
+
+	auto compressedSize = compressBound( static_cast<uLong>( m_pixelBuffer.size() ) );
+	m_compressionBuffer.resize( static_cast<int>( compressedSize ) );
+
+	if( compress2( reinterpret_cast<Bytef *>( m_compressionBuffer.data() ), &compressedSize,
+				   reinterpret_cast<const Bytef *>( m_pixelBuffer.constData() ), static_cast<uLong>( m_pixelBuffer.size() ),
+				   CompressionLevel ) != Z_OK )
+	{
+		qCritical( "DemoServerTileEncoder::encodeTile(): could not compress tile" );
+		return QByteArray();
+	}
+
+	appendCompactLength( encoding, static_cast<int>( compressedSize ) );
+	encoding.append( m_compressionBuffer.constData(), static_cast<int>( compressedSize ) );
+
+	return encoding;
+}
+
+
+
+void DemoServerTileEncoder::appendUpdateMessageHeader( QByteArray& message, int rectCount )
+{
+	rfbFramebufferUpdateMsg updateMessage;
+	updateMessage.type = rfbFramebufferUpdate;
+	updateMessage.pad = 0;
+	updateMessage.nRects = qToBigEndian<uint16_t>( static_cast<uint16_t>( rectCount ) );
+
+	message.append( reinterpret_cast<const char *>( &updateMessage ), sz_rfbFramebufferUpdateMsg );
+}
+
+
+
+void DemoServerTileEncoder::appendRectHeader( QByteArray& message, const QRect& rect, int encoding )
+{
+	rfbFramebufferUpdateRectHeader rectHeader;
+	rectHeader.encoding = qToBigEndian<uint32_t>( static_cast<uint32_t>( encoding ) );
+	rectHeader.r.x = qToBigEndian<uint16_t>( static_cast<uint16_t>( rect.x() ) );
+	rectHeader.r.y = qToBigEndian<uint16_t>( static_cast<uint16_t>( rect.y() ) );
+	rectHeader.r.w = qToBigEndian<uint16_t>( static_cast<uint16_t>( rect.width() ) );
+	rectHeader.r.h = qToBigEndian<uint16_t>( static_cast<uint16_t>( rect.height() ) );
+
+	message.append( reinterpret_cast<const char *>( &rectHeader ), sz_rfbFramebufferUpdateRectHeader );
+}
+
+
+
+void DemoServerTileEncoder::appendCompactLength( QByteArray& message, int length )
+{
+	// 7 bits per byte with the highest bit indicating another byte follows
+	message.append( char( length & 0x7f ) | ( length > 0x7f ? char( 0x80 ) : char( 0 ) ) );
+	if( length > 0x7f )
+	{
+		message.append( char( ( length >> 7 ) & 0x7f ) | ( length > 0x3fff ? char( 0x80 ) : char( 0 ) ) );
+		if( length > 0x3fff )
+		{
+			message.append( char( ( length >> 14 ) & 0xff ) );
+		}
+	}
+}
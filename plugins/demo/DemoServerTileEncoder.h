@@ -0,0 +1,112 @@
+/*
+ * DemoServerTileEncoder.h - header file for DemoServerTileEncoder class
+ *
+ * Copyright (c) 2017 Tobias Junghans <tobydox@users.sf.net>
+ *
+ * This file is part of Veyon - http://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef DEMO_SERVER_TILE_ENCODER_H
+#define DEMO_SERVER_TILE_ENCODER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QImage>
+#include <QRegion>
+#include <QVector>
+
+// re-encodes the demo server's framebuffer into fixed-size Tight tiles - each
+// tile is encoded independently (fill or zlib with stream reset) so encoded tiles
+// can be shared by all clients, reused for key frames and looked up by content hash
+class DemoServerTileEncoder
+{
+public:
+	enum {
+		TileSize = 64,
+		CompressionLevel = 6,
+		MinimumCompressedSize = 12,		/**< smaller data is sent uncompressed (TIGHT_MIN_TO_COMPRESS) */
+		MaximumCachedEncodings = 8192
+	};
+
+	struct EncodedTile
+	{
+		int index;
+		quint64 hash;
+		QRect rect;
+		QByteArray tightData;
+	} ;
+
+	typedef QVector<EncodedTile> EncodedTiles;
+
+	DemoServerTileEncoder();
+
+	void reset( const QSize& framebufferSize );
+
+	const QSize& framebufferSize() const
+	{
+		return m_framebufferSize;
+	}
+
+	// encodes all tiles in region whose contents changed since they were encoded
+	// last time - the tiles used for key frames are left untouched so this can run
+	// while other threads generate key frames
+	EncodedTiles encodeChangedTiles( const QImage& framebuffer, const QRegion& region );
+
+	// takes over tiles returned by encodeChangedTiles() and returns update message
+	// with them or empty array if nothing changed
+	QByteArray applyEncodedTiles( const EncodedTiles& tiles, const QSize& framebufferSize, bool announceSize );
+
+	QByteArray encodeKeyFrame( bool announceSize ) const;
+
+	// takes over tiles of an update message generated by another encoder
+	// (e.g. when relaying a demo stream) so key frames can be generated
+	// without decoding and re-encoding anything
+	bool applyUpdate( const QByteArray& message );
+
+private:
+	struct Tile
+	{
+		quint64 hash;
+		bool valid;
+		QByteArray encoding;	/**< rect header + Tight data */
+	} ;
+
+	static int tightDataSize( const char* data, qint64 size, const QRect& rect );
+
+	static quint64 tileHash( const QImage& framebuffer, const QRect& rect );
+	QByteArray encodeTile( const QImage& framebuffer, const QRect& rect );
+
+	static void appendUpdateMessageHeader( QByteArray& message, int rectCount );
+	static void appendRectHeader( QByteArray& message, const QRect& rect, int encoding );
+	static void appendCompactLength( QByteArray& message, int length );
+
+	QSize m_framebufferSize;
+	int m_columns;
+	int m_rows;
+	QVector<Tile> m_tiles;
+
+	// Tight data of recently seen tile contents, e.g. when switching back to a previous window
+	QHash<quint64, QByteArray> m_encodingCache;
+
+	QByteArray m_pixelBuffer;
+	QByteArray m_compressionBuffer;
+
+} ;
+
+#endif
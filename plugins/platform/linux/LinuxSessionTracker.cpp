@@ -0,0 +1,119 @@
+/*
+ * LinuxSessionTracker.cpp - implementation of LinuxSessionTracker class
+ *
+ * Copyright (c) 2017 Tobias Junghans <tobydox@users.sf.net>
+ *
+ * This file is part of Veyon - http://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include <QDebug>
+
+#include "LinuxSessionTracker.h"
+
+#include <string.h>
+#include <utmpx.h>
+
+
+LinuxSessionTracker::LinuxSessionTracker( QObject* parent ) :
+	QObject( parent ),
+	m_utmpWatcher( this ),
+	m_watching( false ),
+	m_mutex(),
+	m_loggedOnUsers()
+{
+	// QFileSystemWatcher uses inotify so we only get woken up when sessions change
+	m_watching = m_utmpWatcher.addPath( QStringLiteral( _PATH_UTMPX ) );
+
+	if( m_watching == false )
+	{
+		qWarning() << "LinuxSessionTracker: can't watch" << _PATH_UTMPX << "- reading it for each query";
+	}
+
+	connect( &m_utmpWatcher, &QFileSystemWatcher::fileChanged, this, &LinuxSessionTracker::update );
+
+	m_loggedOnUsers = readLoggedOnUsers();
+}
+
+
+
+QStringList LinuxSessionTracker::loggedOnUsers() const
+{
+	if( m_watching == false )
+	{
+		return readLoggedOnUsers();
+	}
+
+	QMutexLocker locker( &m_mutex );
+	return m_loggedOnUsers;
+}
+
+
+
+void LinuxSessionTracker::update()
+{
+	// file might have been replaced and is not watched any longer then
+	if( m_utmpWatcher.files().isEmpty() )
+	{
+		m_utmpWatcher.addPath( QStringLiteral( _PATH_UTMPX ) );
+	}
+
+	const auto users = readLoggedOnUsers();
+
+	m_mutex.lock();
+	const auto changed = users != m_loggedOnUsers;
+	m_loggedOnUsers = users;
+	m_mutex.unlock();
+
+	if( changed )
+	{
+		emit loggedOnUsersChanged();
+	}
+}
+
+
+
+QStringList LinuxSessionTracker::readLoggedOnUsers()
+{
+	// the utmpx functions share one file position for the whole process
+	static QMutex utmpMutex;
+	QMutexLocker locker( &utmpMutex );
+
+	QStringList users;
+
+	setutxent();
+
+	while( const auto entry = getutxent() )
+	{
+		if( entry->ut_type != USER_PROCESS )
+		{
+			continue;
+		}
+
+		// ut_user is not necessarily null-terminated
+		const auto user = QString::fromUtf8( entry->ut_user, static_cast<int>( strnlen( entry->ut_user, sizeof( entry->ut_user ) ) ) );
+		if( user.isEmpty() == false && users.contains( user ) == false )
+		{
+			users.append( user ); // clazy:exclude=reserve-candidates
+		}
+	}
+
+	endutxent();
+
+	return users;
+}
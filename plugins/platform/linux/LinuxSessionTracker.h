@@ -0,0 +1,58 @@
+/*
+ * LinuxSessionTracker.h - declaration of LinuxSessionTracker class
+ *
+ * Copyright (c) 2017 Tobias Junghans <tobydox@users.sf.net>
+ *
+ * This file is part of Veyon - http://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef LINUX_SESSION_TRACKER_H
+#define LINUX_SESSION_TRACKER_H
+
+#include <QFileSystemWatcher>
+#include <QMutex>
+#include <QStringList>
+
+// keeps list of logged on users read from utmp up to date by watching the file
+// for changes instead of running "who" for each query
+class LinuxSessionTracker : public QObject
+{
+	Q_OBJECT
+public:
+	LinuxSessionTracker( QObject* parent = nullptr );
+
+	QStringList loggedOnUsers() const;
+
+signals:
+	void loggedOnUsersChanged();
+
+private:
+	void update();
+
+	static QStringList readLoggedOnUsers();
+
+	QFileSystemWatcher m_utmpWatcher;
+	bool m_watching;
+
+	mutable QMutex m_mutex;
+	QStringList m_loggedOnUsers;
+
+} ;
+
+#endif // LINUX_SESSION_TRACKER_H
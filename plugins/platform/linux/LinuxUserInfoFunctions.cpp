@@ -22,14 +22,26 @@
  *
  */
 
-#include <QProcess>
+#include <QVector>
 
 #include "LinuxUserInfoFunctions.h"
 #include "LocalSystem.h"
 
+#include <errno.h>
+#include <grp.h>
 #include <pwd.h>
 
 
+LinuxUserInfoFunctions::LinuxUserInfoFunctions() :
+	m_groupCacheMutex(),
+	m_userGroups( { QStringList(), QElapsedTimer(), GroupCacheLifetime } ),
+	m_groupsOfUser(),
+	m_sessionTracker()
+{
+}
+
+
+
 QString LinuxUserInfoFunctions::fullName( const QString& username )
 {
 	auto pw_entry = getpwnam( VeyonCore::stripDomain( username ).toUtf8().constData() );
@@ -55,21 +67,94 @@ QString LinuxUserInfoFunctions::fullName( const QString& username )
 
 QStringList LinuxUserInfoFunctions::userGroups()
 {
+	QMutexLocker locker( &m_groupCacheMutex );
+
+	if( m_userGroups.timer.isValid() == false || m_userGroups.timer.hasExpired( m_userGroups.lifetime ) )
+	{
+		m_userGroups.groups = queryUserGroups();
+		m_userGroups.timer.start();
+	}
+
+	return m_userGroups.groups;
+}
+
+
+
+QStringList LinuxUserInfoFunctions::groupsOfUser( const QString& username )
+{
+	const auto strippedUsername = VeyonCore::stripDomain( username );
+
+	QMutexLocker locker( &m_groupCacheMutex );
+
+	auto it = m_groupsOfUser.find( strippedUsername );
+	if( it != m_groupsOfUser.end() && it->timer.hasExpired( it->lifetime ) == false )
+	{
+		return it->groups;
+	}
+
 	QStringList groupList;
 
-	QProcess getentProcess;
-	getentProcess.start( QStringLiteral("getent"), { QStringLiteral("group") } );
-	getentProcess.waitForFinished();
+	// also remember unknown users for a while as looking them up usually takes longest
+	const auto lifetime = queryGroupsOfUser( strippedUsername, &groupList ) ? GroupCacheLifetime : UnknownUserCacheLifetime;
 
-	const auto groups = QString( getentProcess.readAll() ).split( '\n' );
+	// usernames are supplied by connecting clients so keep the cache from growing unbounded
+	for( it = m_groupsOfUser.begin(); it != m_groupsOfUser.end(); )
+	{
+		if( it->timer.hasExpired( it->lifetime ) )
+		{
+			it = m_groupsOfUser.erase( it );
+		}
+		else
+		{
+			++it;
+		}
+	}
 
-	groupList.reserve( groups.size() );
+	if( m_groupsOfUser.size() >= MaximumCachedUsers )
+	{
+		m_groupsOfUser.clear();
+	}
+
+	QElapsedTimer timer;
+	timer.start();
 
-	for( const auto& group : groups )
+	m_groupsOfUser[strippedUsername] = CachedGroupList { groupList, timer, lifetime };
+
+	return groupList;
+}
+
+
+
+QStringList LinuxUserInfoFunctions::queryUserGroups()
+{
+	QStringList groupList;
+
+	QByteArray buffer( InitialBufferSize, 0 );
+	struct group groupEntry;
+	struct group* result = nullptr;
+
+	setgrent();
+
+	forever
 	{
-		groupList += group.split( ':' ).first();
+		const auto error = getgrent_r( &groupEntry, buffer.data(), static_cast<size_t>( buffer.size() ), &result );
+		if( error == ERANGE )
+		{
+			// same entry is returned again with a larger buffer
+			buffer.resize( buffer.size() * 2 );
+			continue;
+		}
+
+		if( error != 0 || result == nullptr )
+		{
+			break;
+		}
+
+		groupList += QString::fromUtf8( result->gr_name ); // clazy:exclude=reserve-candidates
 	}
 
+	endgrent();
+
 	const QStringList ignoredGroups( {
 		"root",
 		"daemon",
@@ -158,30 +243,76 @@ QStringList LinuxUserInfoFunctions::userGroups()
 
 
 
-QStringList LinuxUserInfoFunctions::groupsOfUser( const QString& username )
+bool LinuxUserInfoFunctions::queryGroupsOfUser( const QString& username, QStringList* groups )
 {
-	QStringList groupList;
+	const auto name = username.toUtf8();
 
-	const auto strippedUsername = VeyonCore::stripDomain( username );
+	QByteArray buffer( InitialBufferSize, 0 );
+	struct passwd passwdEntry;
+	struct passwd* passwdResult = nullptr;
+
+	while( getpwnam_r( name.constData(), &passwdEntry, buffer.data(), static_cast<size_t>( buffer.size() ),
+					   &passwdResult ) == ERANGE )
+	{
+		buffer.resize( buffer.size() * 2 );
+	}
+
+	if( passwdResult == nullptr )
+	{
+		return false;
+	}
+
+	const auto primaryGroupId = passwdResult->pw_gid;
+
+	// let NSS resolve all groups of the user at once (e.g. via initgroups of SSSD)
+	// instead of searching through the member lists of all groups
+	int groupCount = 64;
+	QVector<gid_t> groupIds( groupCount );
+
+	while( getgrouplist( name.constData(), primaryGroupId, groupIds.data(), &groupCount ) < 0 )
+	{
+		groupCount = qMax( groupCount, groupIds.size() * 2 );
+		groupIds.resize( groupCount );
+	}
+
+	groups->clear();
+	groups->reserve( groupCount );
 
-	QProcess getentProcess;
-	getentProcess.start( QStringLiteral("getent"), { QStringLiteral("group") } );
-	getentProcess.waitForFinished();
+	struct group groupEntry;
+	struct group* groupResult = nullptr;
 
-	const auto groups = QString( getentProcess.readAll() ).split( '\n' );
-	for( const auto& group : groups )
+	for( int i = 0; i < groupCount; ++i )
 	{
-		const auto groupComponents = group.split( ':' );
-		if( groupComponents.size() == 4 &&
-				groupComponents.last().split( ',' ).contains( strippedUsername ) )
+		int error = 0;
+		while( ( error = getgrgid_r( groupIds[i], &groupEntry, buffer.data(), static_cast<size_t>( buffer.size() ),
+									 &groupResult ) ) == ERANGE )
 		{
-			groupList += groupComponents.first(); // clazy:exclude=reserve-candidates
+			buffer.resize( buffer.size() * 2 );
+		}
+
+		if( error != 0 || groupResult == nullptr )
+		{
+			continue;
+		}
+
+		// getgrouplist() always includes the primary group - only report it if the user
+		// is listed as member explicitly so access control rules see the same groups as
+		// before and no user gains access via a group shared with all other users
+		bool isMember = groupIds[i] != primaryGroupId;
+		for( auto member = groupResult->gr_mem; isMember == false && member && *member; ++member )
+		{
+			isMember = name == *member;
+		}
+
+		if( isMember )
+		{
+			groups->append( QString::fromUtf8( groupResult->gr_name ) );
 		}
 	}
 
-	groupList.removeAll( QStringLiteral("") );
+	groups->removeAll( QStringLiteral("") );
 
-	return groupList;
+	return true;
 }
 
 
@@ -229,26 +360,5 @@ QString LinuxUserInfoFunctions::loggedOnUser()
 
 QStringList LinuxUserInfoFunctions::loggedOnUsers()
 {
-	QStringList users;
-
-	QProcess whoProcess;
-	whoProcess.start( QStringLiteral("who") );
-	whoProcess.waitForFinished( WhoProcessTimeout );
-
-	if( whoProcess.exitCode() != 0 )
-	{
-		return users;
-	}
-
-	const auto lines = whoProcess.readAll().split( '\n' );
-	for( const auto& line : lines )
-	{
-		const auto user = line.split( ' ' ).value( 0 );
-		if( user.isEmpty() == false && users.contains( user ) == false )
-		{
-			users.append( user ); // clazy:exclude=reserve-candidates
-		}
-	}
-
-	return users;
+	return m_sessionTracker.loggedOnUsers();
 }
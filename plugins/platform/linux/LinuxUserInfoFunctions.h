@@ -25,6 +25,11 @@
 #ifndef LINUX_USER_INFO_FUNCTIONS_H
 #define LINUX_USER_INFO_FUNCTIONS_H
 
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+
+#include "LinuxSessionTracker.h"
 #include "PlatformUserInfoFunctions.h"
 
 // clazy:excludeall=copyable-polymorphic
@@ -32,6 +37,8 @@
 class LinuxUserInfoFunctions : public PlatformUserInfoFunctions
 {
 public:
+	LinuxUserInfoFunctions();
+
 	QString fullName( const QString& username ) override;
 
 	QStringList userGroups() override;
@@ -40,10 +47,36 @@ public:
 	QString loggedOnUser() override;
 	QStringList loggedOnUsers() override;
 
+	LinuxSessionTracker& sessionTracker()
+	{
+		return m_sessionTracker;
+	}
+
 private:
 	enum {
-		WhoProcessTimeout = 3000
+		GroupCacheLifetime = 60000,
+		UnknownUserCacheLifetime = 10000,
+		MaximumCachedUsers = 1024,
+		InitialBufferSize = 16384
 	};
+
+	struct CachedGroupList
+	{
+		QStringList groups;
+		QElapsedTimer timer;
+		int lifetime;
+	} ;
+
+	static QStringList queryUserGroups();
+	static bool queryGroupsOfUser( const QString& username, QStringList* groups );
+
+	// group lookups may involve network services (e.g. SSSD/LDAP) so cache results
+	QMutex m_groupCacheMutex;
+	CachedGroupList m_userGroups;
+	QHash<QString, CachedGroupList> m_groupsOfUser;
+
+	LinuxSessionTracker m_sessionTracker;
+
 };
 
 #endif // LINUX_USER_INFO_FUNCTIONS_H
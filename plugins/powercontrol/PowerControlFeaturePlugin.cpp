@@ -80,6 +80,9 @@ bool PowerControlFeaturePlugin::startMasterFeature( const Feature& feature,
 		for( auto controlInterface : computerControlInterfaces )
 		{
 			PowerControl::broadcastWOLPacket( controlInterface->computer().macAddress() );
+
+			// computer is going to boot so stop backing off connection attempts
+			controlInterface->retryConnectionNow();
 		}
 	}
 	else
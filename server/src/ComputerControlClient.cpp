@@ -27,6 +27,9 @@
 #include "VeyonCore.h"
 #include "ComputerControlClient.h"
 #include "ComputerControlServer.h"
+#include "FeatureMessage.h"
+#include "ScaledFramebufferMessage.h"
+#include "VeyonConfiguration.h"
 
 
 ComputerControlClient::ComputerControlClient( ComputerControlServer* server,
@@ -41,8 +44,14 @@ ComputerControlClient::ComputerControlClient( ComputerControlServer* server,
 					  &m_serverClient,
 					  server->authenticationManager(),
 					  server->accessControlManager() ),
-	m_clientProtocol( vncServerSocket(), vncServerPassword )
+	m_clientProtocol( vncServerSocket(), vncServerPassword ),
+	m_scaledFramebufferSender( server->framebufferMirror(), clientSocket, this ),
+	m_sharedFramebufferSession( false )
 {
+	// continue protocol right away when authentication finishes asynchronously
+	connect( &m_serverClient, &VncServerClient::authenticationFinished,
+			 this, &ComputerControlClient::readFromClient );
+
 	m_serverProtocol.start();
 	m_clientProtocol.start();
 }
@@ -66,10 +75,199 @@ bool ComputerControlClient::receiveClientMessage()
 		return false;
 	}
 
-	if( messageType == rfbVeyonFeatureMessage )
+	switch( messageType )
 	{
-		return m_server->handleFeatureMessage( socket );
+	case rfbVeyonFeatureMessage:
+		return m_server->handleFeatureMessage( this );
+
+	case rfbSetPixelFormat:
+		return receivePixelFormat();
+
+	case rfbSetEncodings:
+		return receiveEncodings();
+
+	case rfbFramebufferUpdateRequest:
+		if( m_scaledFramebufferSender.isActive() )
+		{
+			return receiveFramebufferUpdateRequest();
+		}
+		break;
+
+	default:
+		break;
 	}
 
 	return VncProxyConnection::receiveClientMessage();
 }
+
+
+
+bool ComputerControlClient::handleScaledFramebufferMessage( const FeatureMessage& message )
+{
+	if( message.command() != ScaledFramebufferMessage::SetScaledSize )
+	{
+		qWarning() << "ComputerControlClient::handleScaledFramebufferMessage(): invalid command" << message.command();
+		return true;
+	}
+
+	const QSize scaledSize( message.argument( ScaledFramebufferMessage::Width ).toInt(),
+							message.argument( ScaledFramebufferMessage::Height ).toInt() );
+
+	if( scaledSize.isEmpty() ||
+			m_scaledFramebufferSender.start( scaledSize,
+										 message.argument( ScaledFramebufferMessage::UpdateInterval ).toInt() ) == false )
+	{
+		qWarning() << "ComputerControlClient::handleScaledFramebufferMessage(): can't send scaled framebuffer of size"
+				   << scaledSize << "- keeping full framebuffer updates";
+	}
+	else
+	{
+		// updates of the real VNC server have to be dropped from now on
+		m_clientProtocol.setFramebufferUpdateForwardingDevice( nullptr );
+		m_sharedFramebufferSession = false;
+	}
+
+	return true;
+}
+
+
+
+bool ComputerControlClient::receiveServerMessage()
+{
+	if( clientProtocol().receiveMessage() )
+	{
+		// framebuffer updates of the real VNC server are replaced with the ones of the shared framebuffer mirror
+		if( clientProtocol().isLastMessageForwarded() == false &&
+				( m_scaledFramebufferSender.isActive() == false ||
+				  clientProtocol().lastMessageType() != rfbFramebufferUpdate ) )
+		{
+			proxyClientSocket()->write( clientProtocol().lastMessage() );
+		}
+		else if( m_sharedFramebufferSession &&
+				 clientProtocol().lastCursorUpdateMessage().isEmpty() == false )
+		{
+			// cursor shape and position are not part of the shared framebuffer
+			// so pass them through to the client
+			proxyClientSocket()->write( clientProtocol().lastCursorUpdateMessage() );
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+
+
+bool ComputerControlClient::receivePixelFormat()
+{
+	rfbSetPixelFormatMsg message;
+	if( proxyClientSocket()->peek( reinterpret_cast<char *>( &message ), sz_rfbSetPixelFormatMsg ) != sz_rfbSetPixelFormatMsg )
+	{
+		return false;
+	}
+
+	message.format.redMax = qFromBigEndian( message.format.redMax );
+	message.format.greenMax = qFromBigEndian( message.format.greenMax );
+	message.format.blueMax = qFromBigEndian( message.format.blueMax );
+
+	m_scaledFramebufferSender.setPixelFormat( message.format );
+
+	return VncProxyConnection::receiveClientMessage();
+}
+
+
+
+bool ComputerControlClient::receiveEncodings()
+{
+	auto socket = proxyClientSocket();
+
+	rfbSetEncodingsMsg message;
+	if( socket->peek( reinterpret_cast<char *>( &message ), sz_rfbSetEncodingsMsg ) != sz_rfbSetEncodingsMsg )
+	{
+		return false;
+	}
+
+	const int encodingCount = qFromBigEndian( message.nEncodings );
+	const qint64 messageSize = sz_rfbSetEncodingsMsg + encodingCount * sizeof(uint32_t);
+
+	const auto data = socket->peek( messageSize );
+	if( data.size() != messageSize )
+	{
+		return false;
+	}
+
+	QVector<uint32_t> encodings;
+	encodings.reserve( encodingCount );
+
+	const auto encodingData = reinterpret_cast<const uint32_t *>( data.constData() + sz_rfbSetEncodingsMsg );
+	for( int i = 0; i < encodingCount; ++i )
+	{
+		encodings.append( qFromBigEndian( encodingData[i] ) );
+	}
+
+	if( VncProxyConnection::receiveClientMessage() == false )
+	{
+		return false;
+	}
+
+	startSharedFramebufferSession( encodings );
+
+	return true;
+}
+
+
+
+void ComputerControlClient::startSharedFramebufferSession( const QVector<uint32_t>& encodings )
+{
+	// let the shared framebuffer mirror serve all clients which can decode our updates
+	// so the VNC server does not have to encode the screen for each of them
+	if( VeyonCore::config().isSharedFramebufferSessionEnabled() == false ||
+			m_scaledFramebufferSender.isActive() ||
+			m_scaledFramebufferSender.isPixelFormatSupported() == false ||
+			encodings.contains( rfbEncodingZlib ) == false ||
+			encodings.contains( rfbEncodingNewFBSize ) == false )
+	{
+		return;
+	}
+
+	if( m_scaledFramebufferSender.start( QSize(), 0 ) )
+	{
+		m_clientProtocol.setFramebufferUpdateForwardingDevice( nullptr );
+		m_sharedFramebufferSession = true;
+	}
+}
+
+
+
+bool ComputerControlClient::receiveFramebufferUpdateRequest()
+{
+	if( proxyClientSocket()->bytesAvailable() < sz_rfbFramebufferUpdateRequestMsg )
+	{
+		return false;
+	}
+
+	rfbFramebufferUpdateRequestMsg message;
+	if( proxyClientSocket()->read( reinterpret_cast<char *>( &message ), sz_rfbFramebufferUpdateRequestMsg ) != sz_rfbFramebufferUpdateRequestMsg )
+	{
+		return false;
+	}
+
+	m_scaledFramebufferSender.requestUpdate( message.incremental );
+
+	if( m_sharedFramebufferSession )
+	{
+		// keep requesting updates from the real VNC server so it continues to
+		// send cursor shape and position updates - restrict the request to a
+		// single pixel as any framebuffer data in its reply is dropped anyway
+		message.incremental = 1;
+		message.x = 0;
+		message.y = 0;
+		message.w = qToBigEndian<uint16_t>( 1 );
+		message.h = qToBigEndian<uint16_t>( 1 );
+
+		vncServerSocket()->write( reinterpret_cast<const char *>( &message ), sz_rfbFramebufferUpdateRequestMsg );
+	}
+
+	return true;
+}
@@ -25,12 +25,14 @@
 #ifndef COMPUTER_CONTROL_CLIENT_H
 #define COMPUTER_CONTROL_CLIENT_H
 
+#include "ScaledFramebufferSender.h"
 #include "VncClientProtocol.h"
 #include "VncProxyConnection.h"
 #include "VncServerClient.h"
 #include "VeyonServerProtocol.h"
 
 class ComputerControlServer;
+class FeatureMessage;
 
 class ComputerControlClient : public VncProxyConnection
 {
@@ -45,7 +47,11 @@ public:
 
 	bool receiveClientMessage() override;
 
+	bool handleScaledFramebufferMessage( const FeatureMessage& message );
+
 protected:
+	bool receiveServerMessage() override;
+
 	VncClientProtocol& clientProtocol() override
 	{
 		return m_clientProtocol;
@@ -57,6 +63,11 @@ protected:
 	}
 
 private:
+	bool receivePixelFormat();
+	bool receiveEncodings();
+	void startSharedFramebufferSession( const QVector<uint32_t>& encodings );
+	bool receiveFramebufferUpdateRequest();
+
 	ComputerControlServer* m_server;
 
 	VncServerClient m_serverClient;
@@ -64,6 +75,9 @@ private:
 	VeyonServerProtocol m_serverProtocol;
 	VncClientProtocol m_clientProtocol;
 
+	ScaledFramebufferSender m_scaledFramebufferSender;
+	bool m_sharedFramebufferSession;
+
 } ;
 
 #endif
@@ -29,6 +29,8 @@
 #include "ComputerControlServer.h"
 #include "ComputerControlClient.h"
 #include "FeatureMessage.h"
+#include "FramebufferMirror.h"
+#include "ScaledFramebufferMessage.h"
 #include "VeyonConfiguration.h"
 #include "LocalSystem.h"
 #include "SystemTrayIcon.h"
@@ -48,7 +50,8 @@ ComputerControlServer::ComputerControlServer( QObject* parent ) :
 						  QHostAddress::LocalHost : QHostAddress::Any,
 					  VeyonCore::config().primaryServicePort(),
 					  this,
-					  this )
+					  this ),
+	m_framebufferMirror( nullptr )
 {
 	m_builtinFeatures.systemTrayIcon().setToolTip(
 				tr( "%1 Service %2 at %3:%4" ).arg( VeyonCore::applicationName(), QStringLiteral(VEYON_VERSION),
@@ -77,6 +80,9 @@ ComputerControlServer::~ComputerControlServer()
 void ComputerControlServer::start()
 {
 	m_vncServer.start();
+
+	m_framebufferMirror = new FramebufferMirror( m_vncServer.serverPort(), m_vncServer.password(), this );
+
 	m_vncProxyServer.start( m_vncServer.serverPort(), m_vncServer.password() );
 }
 
@@ -92,8 +98,10 @@ VncProxyConnection* ComputerControlServer::createVncProxyConnection( QTcpSocket*
 
 
 
-bool ComputerControlServer::handleFeatureMessage( QTcpSocket* socket )
+bool ComputerControlServer::handleFeatureMessage( ComputerControlClient* client )
 {
+	auto socket = client->proxyClientSocket();
+
 	char messageType;
 	if( socket->getChar( &messageType ) == false )
 	{
@@ -111,6 +119,11 @@ bool ComputerControlServer::handleFeatureMessage( QTcpSocket* socket )
 
 	featureMessage.receive();
 
+	if( featureMessage.featureUid() == ScaledFramebufferMessage::featureUid() )
+	{
+		return client->handleScaledFramebufferMessage( featureMessage );
+	}
+
 	return m_featureManager.handleServiceFeatureMessage( featureMessage, m_featureWorkerManager );
 }
 
@@ -38,6 +38,9 @@
 #include "VncProxyConnectionFactory.h"
 #include "VncServer.h"
 
+class ComputerControlClient;
+class FramebufferMirror;
+
 class ComputerControlServer : public QObject, VncProxyConnectionFactory
 {
 	Q_OBJECT
@@ -62,7 +65,12 @@ public:
 		return m_serverAccessControlManager;
 	}
 
-	bool handleFeatureMessage( QTcpSocket* socket );
+	FramebufferMirror* framebufferMirror()
+	{
+		return m_framebufferMirror;
+	}
+
+	bool handleFeatureMessage( ComputerControlClient* client );
 
 	void setAllowedIPs( const QStringList &allowedIPs );
 
@@ -85,6 +93,8 @@ private:
 	VncServer m_vncServer;
 	VncProxyServer m_vncProxyServer;
 
+	FramebufferMirror* m_framebufferMirror;
+
 } ;
 
 #endif
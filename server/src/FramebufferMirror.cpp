@@ -0,0 +1,334 @@
+/*
+ * FramebufferMirror.cpp - local copy of the framebuffer of the VNC server
+ *
+ * Copyright (c) 2017 Tobias Junghans <tobydox@users.sf.net>
+ *
+ * This file is part of Veyon - http://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include <QHostAddress>
+#include <QTcpSocket>
+
+#include "FramebufferMirror.h"
+
+
+FramebufferMirror::FramebufferMirror( int vncServerPort, const QString& vncServerPassword, QObject* parent ) :
+	QObject( parent ),
+	m_vncServerPort( vncServerPort ),
+	m_vncServerSocket( new QTcpSocket( this ) ),
+	m_vncClientProtocol( m_vncServerSocket, vncServerPassword ),
+	m_framebufferUpdateTimer( this ),
+	m_requestFullFramebufferUpdate( false ),
+	m_userUpdateIntervals(),
+	m_image()
+{
+	connect( m_vncServerSocket, &QTcpSocket::readyRead, this, &FramebufferMirror::readFromVncServer );
+	connect( m_vncServerSocket, &QTcpSocket::disconnected, this, &FramebufferMirror::reconnectToVncServer );
+
+	connect( &m_framebufferUpdateTimer, &QTimer::timeout, this, &FramebufferMirror::requestFramebufferUpdate );
+}
+
+
+
+FramebufferMirror::~FramebufferMirror()
+{
+	m_vncServerSocket->disconnect( this );
+
+	delete m_vncServerSocket;
+}
+
+
+
+void FramebufferMirror::attach( const QObject* user, int updateInterval )
+{
+	const bool firstUser = m_userUpdateIntervals.isEmpty();
+
+	m_userUpdateIntervals[user] = updateInterval;
+
+	if( firstUser )
+	{
+		reconnectToVncServer();
+	}
+
+	updatePollInterval();
+}
+
+
+
+void FramebufferMirror::detach( const QObject* user )
+{
+	if( m_userUpdateIntervals.remove( user ) == 0 )
+	{
+		return;
+	}
+
+	if( m_userUpdateIntervals.isEmpty() )
+	{
+		m_framebufferUpdateTimer.stop();
+
+		// does not reconnect as there are no users left
+		m_vncServerSocket->abort();
+
+		m_image = QImage();
+	}
+	else
+	{
+		updatePollInterval();
+	}
+}
+
+
+
+void FramebufferMirror::updatePollInterval()
+{
+	// poll as often as the most demanding user requires but not more often
+	int interval = -1;
+
+	for( auto userInterval : qAsConst( m_userUpdateIntervals ) )
+	{
+		userInterval = qMax<int>( userInterval, MinimumUpdateInterval );
+		interval = interval < 0 ? userInterval : qMin( interval, userInterval );
+	}
+
+	if( interval > 0 && ( m_framebufferUpdateTimer.isActive() == false ||
+						  m_framebufferUpdateTimer.interval() != interval ) )
+	{
+		m_framebufferUpdateTimer.start( interval );
+	}
+}
+
+
+
+void FramebufferMirror::reconnectToVncServer()
+{
+	if( m_userUpdateIntervals.isEmpty() )
+	{
+		return;
+	}
+
+	m_vncClientProtocol.start();
+
+	m_vncServerSocket->connectToHost( QHostAddress::LocalHost, m_vncServerPort );
+}
+
+
+
+void FramebufferMirror::readFromVncServer()
+{
+	if( m_vncClientProtocol.state() != VncClientProtocol::Running )
+	{
+		while( m_vncClientProtocol.read() )
+		{
+		}
+
+		if( m_vncClientProtocol.state() == VncClientProtocol::Running )
+		{
+			start();
+		}
+	}
+	else
+	{
+		while( receiveVncServerMessage() )
+		{
+		}
+	}
+}
+
+
+
+void FramebufferMirror::requestFramebufferUpdate()
+{
+	if( m_vncClientProtocol.state() != VncClientProtocol::Running )
+	{
+		return;
+	}
+
+	m_vncClientProtocol.requestFramebufferUpdate( m_requestFullFramebufferUpdate == false );
+	m_requestFullFramebufferUpdate = false;
+}
+
+
+
+void FramebufferMirror::start()
+{
+	setVncServerPixelFormat();
+	setVncServerEncodings();
+
+	m_image = QImage( m_vncClientProtocol.framebufferWidth(), m_vncClientProtocol.framebufferHeight(),
+					  QImage::Format_RGB32 );
+	m_image.fill( Qt::black );
+
+	m_requestFullFramebufferUpdate = true;
+
+	requestFramebufferUpdate();
+
+	while( receiveVncServerMessage() )
+	{
+	}
+}
+
+
+
+bool FramebufferMirror::setVncServerPixelFormat()
+{
+	rfbPixelFormat format;
+
+	format.bitsPerPixel = 32;
+	format.depth = 32;
+	format.bigEndian = qFromBigEndian<uint16_t>( 1 ) == 1 ? true : false;
+	format.trueColour = 1;
+	format.redShift = 16;
+	format.greenShift = 8;
+	format.blueShift = 0;
+	format.redMax = 0xff;
+	format.greenMax = 0xff;
+	format.blueMax = 0xff;
+
+	return m_vncClientProtocol.setPixelFormat( format );
+}
+
+
+
+bool FramebufferMirror::setVncServerEncodings()
+{
+	return m_vncClientProtocol.
+			setEncodings( {
+							  rfbEncodingCopyRect,
+							  rfbEncodingRaw,
+							  rfbEncodingNewFBSize,
+							  rfbEncodingLastRect
+						  } );
+}
+
+
+
+bool FramebufferMirror::receiveVncServerMessage()
+{
+	if( m_vncClientProtocol.receiveMessage() )
+	{
+		if( m_vncClientProtocol.lastMessageType() == rfbFramebufferUpdate &&
+				handleFramebufferUpdate( m_vncClientProtocol.lastMessage() ) )
+		{
+			emit framebufferUpdated();
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+
+
+bool FramebufferMirror::handleFramebufferUpdate( const QByteArray& message )
+{
+	// message has been validated by VncClientProtocol already so only check bounds here
+	const auto data = reinterpret_cast<const uchar *>( message.constData() );
+	const int size = message.size();
+	int pos = sz_rfbFramebufferUpdateMsg;
+
+	rfbFramebufferUpdateMsg header;
+	memcpy( &header, data, sz_rfbFramebufferUpdateMsg );
+
+	const int rectCount = qFromBigEndian( header.nRects );
+
+	bool updated = false;
+
+	for( int i = 0; i < rectCount && pos + sz_rfbFramebufferUpdateRectHeader <= size; ++i )
+	{
+		rfbFramebufferUpdateRectHeader rectHeader;
+		memcpy( &rectHeader, data + pos, sz_rfbFramebufferUpdateRectHeader );
+		pos += sz_rfbFramebufferUpdateRectHeader;
+
+		const QRect rect( qFromBigEndian( rectHeader.r.x ), qFromBigEndian( rectHeader.r.y ),
+						  qFromBigEndian( rectHeader.r.w ), qFromBigEndian( rectHeader.r.h ) );
+		const auto encoding = qFromBigEndian( rectHeader.encoding );
+
+		if( encoding == rfbEncodingLastRect )
+		{
+			break;
+		}
+
+		switch( encoding )
+		{
+		case rfbEncodingNewFBSize:
+			m_image = QImage( rect.size(), QImage::Format_RGB32 );
+			m_image.fill( Qt::black );
+			m_requestFullFramebufferUpdate = true;
+			updated = true;
+			break;
+
+		case rfbEncodingRaw:
+		{
+			const int bytesPerLine = rect.width() * sizeof(QRgb);
+			if( pos + bytesPerLine * rect.height() > size )
+			{
+				return updated;
+			}
+
+			if( m_image.rect().contains( rect ) )
+			{
+				for( int y = 0; y < rect.height(); ++y )
+				{
+					memcpy( m_image.scanLine( rect.y() + y ) + rect.x() * sizeof(QRgb),
+							data + pos + y * bytesPerLine, bytesPerLine );
+				}
+				updated = true;
+			}
+
+			pos += bytesPerLine * rect.height();
+			break;
+		}
+
+		case rfbEncodingCopyRect:
+		{
+			if( pos + sz_rfbCopyRect > size )
+			{
+				return updated;
+			}
+
+			rfbCopyRect copyRect;
+			memcpy( &copyRect, data + pos, sz_rfbCopyRect );
+			pos += sz_rfbCopyRect;
+
+			const QRect sourceRect( QPoint( qFromBigEndian( copyRect.srcX ), qFromBigEndian( copyRect.srcY ) ),
+									rect.size() );
+
+			if( m_image.rect().contains( rect ) && m_image.rect().contains( sourceRect ) )
+			{
+				// copy first as source and destination may overlap
+				const auto source = m_image.copy( sourceRect );
+				for( int y = 0; y < rect.height(); ++y )
+				{
+					memcpy( m_image.scanLine( rect.y() + y ) + rect.x() * sizeof(QRgb),
+							source.constScanLine( y ), rect.width() * sizeof(QRgb) );
+				}
+				updated = true;
+			}
+			break;
+		}
+
+		default:
+			// all other encodings we announced have no payload
+			break;
+		}
+	}
+
+	return updated;
+}
@@ -0,0 +1,88 @@
+/*
+ * FramebufferMirror.h - local copy of the framebuffer of the VNC server
+ *
+ * Copyright (c) 2017 Tobias Junghans <tobydox@users.sf.net>
+ *
+ * This file is part of Veyon - http://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef FRAMEBUFFER_MIRROR_H
+#define FRAMEBUFFER_MIRROR_H
+
+#include <QHash>
+#include <QImage>
+#include <QTimer>
+
+#include "VncClientProtocol.h"
+
+class QTcpSocket;
+
+// keeps a decoded copy of the VNC server's framebuffer as long as at least one user
+// is attached - updates are requested in raw encoding as they travel over loopback only
+class FramebufferMirror : public QObject
+{
+	Q_OBJECT
+public:
+	FramebufferMirror( int vncServerPort, const QString& vncServerPassword, QObject* parent );
+	~FramebufferMirror() override;
+
+	// attaches given user or updates the update interval it requested
+	void attach( const QObject* user, int updateInterval );
+	void detach( const QObject* user );
+
+	const QImage& image() const
+	{
+		return m_image;
+	}
+
+signals:
+	void framebufferUpdated();
+
+private slots:
+	void reconnectToVncServer();
+	void readFromVncServer();
+	void requestFramebufferUpdate();
+
+private:
+	enum {
+		MinimumUpdateInterval = 100
+	};
+
+	void updatePollInterval();
+	void start();
+	bool setVncServerPixelFormat();
+	bool setVncServerEncodings();
+
+	bool receiveVncServerMessage();
+	bool handleFramebufferUpdate( const QByteArray& message );
+
+	const int m_vncServerPort;
+
+	QTcpSocket* m_vncServerSocket;
+	VncClientProtocol m_vncClientProtocol;
+	QTimer m_framebufferUpdateTimer;
+	bool m_requestFullFramebufferUpdate;
+
+	QHash<const QObject *, int> m_userUpdateIntervals;
+
+	QImage m_image;
+
+} ;
+
+#endif
@@ -0,0 +1,118 @@
+/*
+ * RsaKeyPool.cpp - implementation of RsaKeyPool
+ *
+ * Copyright (c) 2017 Tobias Junghans <tobydox@users.sf.net>
+ *
+ * This file is part of Veyon - http://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include <QtConcurrent>
+
+#include "CryptoCore.h"
+#include "RsaKeyPool.h"
+
+
+RsaKeyPool::RsaKeyPool() :
+	m_mutex(),
+	m_keyPairs(),
+	m_generatorRunning( false ),
+	m_shutdown( false ),
+	m_generator()
+{
+}
+
+
+
+RsaKeyPool::~RsaKeyPool()
+{
+	m_mutex.lock();
+	m_shutdown = true;
+	m_mutex.unlock();
+
+	m_generator.waitForFinished();
+}
+
+
+
+RsaKeyPool::KeyPair RsaKeyPool::takeKeyPair()
+{
+	m_mutex.lock();
+	const auto keyPair = m_keyPairs.isEmpty() ? KeyPair() : m_keyPairs.dequeue();
+	m_mutex.unlock();
+
+	fill();
+
+	if( keyPair.privateKey.isEmpty() )
+	{
+		// too many authentications in a row so we have to wait anyway
+		qDebug( "RsaKeyPool: no key pair available - generating one synchronously" );
+		return generateKeyPair();
+	}
+
+	return keyPair;
+}
+
+
+
+void RsaKeyPool::fill()
+{
+	QMutexLocker locker( &m_mutex );
+
+	if( m_generatorRunning || m_shutdown || m_keyPairs.size() >= PoolSize )
+	{
+		return;
+	}
+
+	// a single generator thread is enough and does not stall other work on the host
+	m_generatorRunning = true;
+	m_generator = QtConcurrent::run( [this]() { generateKeyPairs(); } );
+}
+
+
+
+RsaKeyPool::KeyPair RsaKeyPool::generateKeyPair()
+{
+	const CryptoCore::PrivateKey privateKey = CryptoCore::KeyGenerator().createRSA( CryptoCore::RsaKeySize );
+
+	// only pass PEM data between threads as QCA objects are bound to the thread they were created in
+	return { privateKey.toPEM(), privateKey.toPublicKey().toPEM() };
+}
+
+
+
+void RsaKeyPool::generateKeyPairs()
+{
+	forever
+	{
+		m_mutex.lock();
+		if( m_shutdown || m_keyPairs.size() >= PoolSize )
+		{
+			m_generatorRunning = false;
+			m_mutex.unlock();
+			return;
+		}
+		m_mutex.unlock();
+
+		const auto keyPair = generateKeyPair();
+
+		m_mutex.lock();
+		m_keyPairs.enqueue( keyPair );
+		m_mutex.unlock();
+	}
+}
@@ -0,0 +1,67 @@
+/*
+ * RsaKeyPool.h - header file for RsaKeyPool
+ *
+ * Copyright (c) 2017 Tobias Junghans <tobydox@users.sf.net>
+ *
+ * This file is part of Veyon - http://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef RSA_KEY_POOL_H
+#define RSA_KEY_POOL_H
+
+#include <QFuture>
+#include <QMutex>
+#include <QQueue>
+
+// keeps a few ephemeral RSA key pairs for logon authentication ready so
+// generating them does not delay authentication - used key pairs are
+// replaced in a background thread
+class RsaKeyPool
+{
+public:
+	struct KeyPair
+	{
+		QString privateKey;		/**< PEM-encoded */
+		QString publicKey;		/**< PEM-encoded */
+	} ;
+
+	enum {
+		PoolSize = 4
+	};
+
+	RsaKeyPool();
+	~RsaKeyPool();
+
+	KeyPair takeKeyPair();
+
+	void fill();
+
+private:
+	static KeyPair generateKeyPair();
+	void generateKeyPairs();
+
+	QMutex m_mutex;
+	QQueue<KeyPair> m_keyPairs;
+	bool m_generatorRunning;
+	bool m_shutdown;
+	QFuture<void> m_generator;
+
+} ;
+
+#endif
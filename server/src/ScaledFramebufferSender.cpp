@@ -0,0 +1,359 @@
+/*
+ * ScaledFramebufferSender.cpp - sends pre-scaled framebuffer updates to a client
+ *
+ * Copyright (c) 2017 Tobias Junghans <tobydox@users.sf.net>
+ *
+ * This file is part of Veyon - http://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include <QTcpSocket>
+
+#include "FramebufferMirror.h"
+#include "ImageScaler.h"
+#include "ScaledFramebufferSender.h"
+
+
+ScaledFramebufferSender::ScaledFramebufferSender( FramebufferMirror* framebufferMirror, QTcpSocket* socket, QObject* parent ) :
+	QObject( parent ),
+	m_framebufferMirror( framebufferMirror ),
+	m_socket( socket ),
+	m_pixelFormat(),
+	m_pixelFormatKnown( false ),
+	m_active( false ),
+	m_scaledSize(),
+	m_updateTimer( this ),
+	m_updateRequested( false ),
+	m_fullUpdateRequested( false ),
+	m_framebufferChanged( false ),
+	m_lastImage(),
+	m_zlibStream(),
+	m_zlibStreamInitialized( false )
+{
+	connect( &m_updateTimer, &QTimer::timeout, this, &ScaledFramebufferSender::sendUpdate );
+}
+
+
+
+ScaledFramebufferSender::~ScaledFramebufferSender()
+{
+	if( m_active && m_framebufferMirror )
+	{
+		m_framebufferMirror->detach( this );
+	}
+
+	if( m_zlibStreamInitialized )
+	{
+		deflateEnd( &m_zlibStream );
+	}
+}
+
+
+
+void ScaledFramebufferSender::setPixelFormat( const rfbPixelFormat& pixelFormat )
+{
+	m_pixelFormat = pixelFormat;
+	m_pixelFormatKnown = true;
+}
+
+
+
+bool ScaledFramebufferSender::start( QSize scaledSize, int updateInterval )
+{
+	if( m_framebufferMirror == nullptr ||
+			scaledSize.width() > 0xffff || scaledSize.height() > 0xffff )
+	{
+		return false;
+	}
+
+	if( isPixelFormatSupported() == false )
+	{
+		qWarning( "ScaledFramebufferSender::start(): unsupported pixel format of client" );
+		return false;
+	}
+
+	// client still waits for an update after its initial request has been dropped
+	const bool fullUpdateRequired = m_active == false || scaledSize != m_scaledSize;
+
+	if( m_active == false )
+	{
+		if( deflateInit( &m_zlibStream, CompressionLevel ) != Z_OK )
+		{
+			qCritical( "ScaledFramebufferSender::start(): could not initialize zlib stream" );
+			return false;
+		}
+
+		m_zlibStreamInitialized = true;
+
+		connect( m_framebufferMirror, &FramebufferMirror::framebufferUpdated,
+				 this, &ScaledFramebufferSender::setFramebufferChanged );
+
+		m_active = true;
+	}
+
+	// also passes changed update intervals of running sessions to the mirror
+	m_framebufferMirror->attach( this, updateInterval );
+
+	m_scaledSize = scaledSize;
+
+	if( fullUpdateRequired )
+	{
+		m_updateRequested = true;
+		m_fullUpdateRequested = true;
+	}
+
+	m_updateTimer.start( qMax<int>( updateInterval, MinimumUpdateInterval ) );
+
+	return true;
+}
+
+
+
+void ScaledFramebufferSender::requestUpdate( bool incremental )
+{
+	m_updateRequested = true;
+
+	if( incremental == false )
+	{
+		m_fullUpdateRequested = true;
+	}
+}
+
+
+
+void ScaledFramebufferSender::setFramebufferChanged()
+{
+	m_framebufferChanged = true;
+}
+
+
+
+void ScaledFramebufferSender::sendUpdate()
+{
+	if( m_updateRequested == false ||
+			( m_framebufferChanged == false && m_fullUpdateRequested == false ) )
+	{
+		return;
+	}
+
+	const auto& framebuffer = m_framebufferMirror->image();
+	if( framebuffer.isNull() )
+	{
+		return;
+	}
+
+	QImage image;
+	if( m_scaledSize.isEmpty() )
+	{
+		image = framebuffer.convertToFormat( QImage::Format_RGB32 );
+	}
+	else
+	{
+		image = ImageScaler::scaled( framebuffer, m_scaledSize.boundedTo( framebuffer.size() ) ).
+				convertToFormat( QImage::Format_RGB32 );
+	}
+
+	const bool resized = image.size() != m_lastImage.size();
+
+	QVector<QRect> rects;
+	if( resized || m_fullUpdateRequested )
+	{
+		rects.append( image.rect() );
+	}
+	else
+	{
+		rects = changedRects( image );
+	}
+
+	m_framebufferChanged = false;
+
+	if( rects.isEmpty() )
+	{
+		// keep request pending until something changes
+		return;
+	}
+
+	QByteArray message;
+
+	rfbFramebufferUpdateMsg header;
+	header.type = rfbFramebufferUpdate;
+	header.pad = 0;
+	header.nRects = qToBigEndian<uint16_t>( rects.size() + ( resized ? 1 : 0 ) );
+	message.append( reinterpret_cast<const char *>( &header ), sz_rfbFramebufferUpdateMsg );
+
+	if( resized )
+	{
+		rfbFramebufferUpdateRectHeader rectHeader;
+		rectHeader.r.x = 0;
+		rectHeader.r.y = 0;
+		rectHeader.r.w = qToBigEndian<uint16_t>( image.width() );
+		rectHeader.r.h = qToBigEndian<uint16_t>( image.height() );
+		rectHeader.encoding = qToBigEndian<uint32_t>( rfbEncodingNewFBSize );
+		message.append( reinterpret_cast<const char *>( &rectHeader ), sz_rfbFramebufferUpdateRectHeader );
+	}
+
+	for( const auto& rect : qAsConst( rects ) )
+	{
+		if( encodeRect( image, rect, message ) == false )
+		{
+			qCritical( "ScaledFramebufferSender::sendUpdate(): could not encode rect - closing connection" );
+			m_socket->close();
+			return;
+		}
+	}
+
+	m_socket->write( message );
+
+	m_lastImage = image;
+	m_updateRequested = false;
+	m_fullUpdateRequested = false;
+}
+
+
+
+bool ScaledFramebufferSender::isPixelFormatSupported() const
+{
+	return m_pixelFormatKnown &&
+			m_pixelFormat.bitsPerPixel == 32 &&
+			m_pixelFormat.trueColour &&
+			m_pixelFormat.redMax == 0xff &&
+			m_pixelFormat.greenMax == 0xff &&
+			m_pixelFormat.blueMax == 0xff;
+}
+
+
+
+QVector<QRect> ScaledFramebufferSender::changedRects( const QImage& image ) const
+{
+	QVector<QRect> rects;
+
+	for( int tileY = 0; tileY < image.height(); tileY += TileSize )
+	{
+		const int tileHeight = qMin<int>( TileSize, image.height() - tileY );
+
+		int runStart = -1;
+
+		for( int tileX = 0; tileX <= image.width(); tileX += TileSize )
+		{
+			bool changed = false;
+
+			if( tileX < image.width() )
+			{
+				const int tileWidth = qMin<int>( TileSize, image.width() - tileX );
+				for( int y = tileY; y < tileY + tileHeight && changed == false; ++y )
+				{
+					changed = memcmp( image.constScanLine( y ) + tileX * sizeof(QRgb),
+									  m_lastImage.constScanLine( y ) + tileX * sizeof(QRgb),
+									  tileWidth * sizeof(QRgb) ) != 0;
+				}
+			}
+
+			// merge horizontally adjacent changed tiles into one rect
+			if( changed && runStart < 0 )
+			{
+				runStart = tileX;
+			}
+			else if( changed == false && runStart >= 0 )
+			{
+				rects.append( QRect( runStart, tileY, qMin( tileX, image.width() ) - runStart, tileHeight ) );
+				runStart = -1;
+			}
+		}
+	}
+
+	return rects;
+}
+
+
+
+bool ScaledFramebufferSender::encodeRect( const QImage& image, const QRect& rect, QByteArray& message )
+{
+	QByteArray pixels( rect.width() * rect.height() * 4, Qt::Uninitialized );
+	auto pixelData = reinterpret_cast<uint32_t *>( pixels.data() );
+
+	for( int y = rect.top(); y <= rect.bottom(); ++y )
+	{
+		const auto scanLine = reinterpret_cast<const QRgb *>( image.constScanLine( y ) );
+		for( int x = rect.left(); x <= rect.right(); ++x )
+		{
+			const auto rgb = scanLine[x];
+			const uint32_t pixel = ( qRed( rgb ) << m_pixelFormat.redShift ) |
+					( qGreen( rgb ) << m_pixelFormat.greenShift ) |
+					( qBlue( rgb ) << m_pixelFormat.blueShift );
+			*pixelData++ = m_pixelFormat.bigEndian ? qToBigEndian( pixel ) : qToLittleEndian( pixel );
+		}
+	}
+
+	QByteArray compressedPixels;
+	if( compress( pixels, compressedPixels ) == false )
+	{
+		return false;
+	}
+
+	rfbFramebufferUpdateRectHeader rectHeader;
+	rectHeader.r.x = qToBigEndian<uint16_t>( rect.x() );
+	rectHeader.r.y = qToBigEndian<uint16_t>( rect.y() );
+	rectHeader.r.w = qToBigEndian<uint16_t>( rect.width() );
+	rectHeader.r.h = qToBigEndian<uint16_t>( rect.height() );
+	rectHeader.encoding = qToBigEndian<uint32_t>( rfbEncodingZlib );
+
+	rfbZlibHeader zlibHeader;
+	zlibHeader.nBytes = qToBigEndian<uint32_t>( compressedPixels.size() );
+
+	message.append( reinterpret_cast<const char *>( &rectHeader ), sz_rfbFramebufferUpdateRectHeader );
+	message.append( reinterpret_cast<const char *>( &zlibHeader ), sz_rfbZlibHeader );
+	message.append( compressedPixels );
+
+	return true;
+}
+
+
+
+bool ScaledFramebufferSender::compress( const QByteArray& data, QByteArray& compressedData )
+{
+	// the client decompresses all rects with one persistent zlib stream
+	compressedData.resize( static_cast<int>( deflateBound( &m_zlibStream, data.size() ) ) + 64 );
+
+	m_zlibStream.next_in = reinterpret_cast<Bytef *>( const_cast<char *>( data.constData() ) );
+	m_zlibStream.avail_in = data.size();
+
+	int written = 0;
+
+	do
+	{
+		if( written == compressedData.size() )
+		{
+			compressedData.resize( compressedData.size() * 2 );
+		}
+
+		m_zlibStream.next_out = reinterpret_cast<Bytef *>( compressedData.data() + written );
+		m_zlibStream.avail_out = compressedData.size() - written;
+
+		if( deflate( &m_zlibStream, Z_SYNC_FLUSH ) == Z_STREAM_ERROR )
+		{
+			return false;
+		}
+
+		written = compressedData.size() - m_zlibStream.avail_out;
+	}
+	while( m_zlibStream.avail_out == 0 );
+
+	compressedData.resize( written );
+
+	return true;
+}
@@ -0,0 +1,97 @@
+/*
+ * ScaledFramebufferSender.h - sends pre-scaled framebuffer updates to a client
+ *
+ * Copyright (c) 2017 Tobias Junghans <tobydox@users.sf.net>
+ *
+ * This file is part of Veyon - http://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef SCALED_FRAMEBUFFER_SENDER_H
+#define SCALED_FRAMEBUFFER_SENDER_H
+
+#include <QImage>
+#include <QTimer>
+
+#include <zlib.h>
+
+#include "VeyonCore.h"
+
+class QTcpSocket;
+class FramebufferMirror;
+
+// answers framebuffer update requests of a client with zlib encoded updates of the
+// shared framebuffer mirror, either scaled down to given size or at native size
+// if no size is given - only tiles which changed since the last update are sent
+class ScaledFramebufferSender : public QObject
+{
+	Q_OBJECT
+public:
+	ScaledFramebufferSender( FramebufferMirror* framebufferMirror, QTcpSocket* socket, QObject* parent );
+	~ScaledFramebufferSender() override;
+
+	bool isActive() const
+	{
+		return m_active;
+	}
+
+	void setPixelFormat( const rfbPixelFormat& pixelFormat );
+
+	bool isPixelFormatSupported() const;
+
+	bool start( QSize scaledSize, int updateInterval );
+
+	void requestUpdate( bool incremental );
+
+private slots:
+	void setFramebufferChanged();
+	void sendUpdate();
+
+private:
+	enum {
+		TileSize = 32,
+		MinimumUpdateInterval = 100,
+		CompressionLevel = 6
+	};
+
+	QVector<QRect> changedRects( const QImage& image ) const;
+	bool encodeRect( const QImage& image, const QRect& rect, QByteArray& message );
+	bool compress( const QByteArray& data, QByteArray& compressedData );
+
+	FramebufferMirror* m_framebufferMirror;
+	QTcpSocket* m_socket;
+
+	rfbPixelFormat m_pixelFormat;
+	bool m_pixelFormatKnown;
+
+	bool m_active;
+	QSize m_scaledSize;
+	QTimer m_updateTimer;
+
+	bool m_updateRequested;
+	bool m_fullUpdateRequested;
+	bool m_framebufferChanged;
+
+	QImage m_lastImage;
+
+	z_stream m_zlibStream;
+	bool m_zlibStreamInitialized;
+
+} ;
+
+#endif
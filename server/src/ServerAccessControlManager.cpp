@@ -29,6 +29,8 @@
 #include "DesktopAccessDialog.h"
 #include "VeyonConfiguration.h"
 #include "LocalSystem.h"
+#include "PlatformPluginInterface.h"
+#include "PlatformUserInfoFunctions.h"
 #include "VariantArrayMessage.h"
 
 
@@ -39,7 +41,8 @@ ServerAccessControlManager::ServerAccessControlManager( FeatureWorkerManager& fe
 	m_featureWorkerManager( featureWorkerManager ),
 	m_desktopAccessDialog( desktopAccessDialog ),
 	m_clients(),
-	m_desktopAccessChoices()
+	m_desktopAccessChoices(),
+	m_accessResultCache()
 {
 }
 
@@ -51,6 +54,7 @@ void ServerAccessControlManager::addClient( VncServerClient* client )
 	{
 	case RfbVeyonAuth::DSA:
 	case RfbVeyonAuth::Logon:
+	case RfbVeyonAuth::Ticket:
 		performAccessControl( client );
 		break;
 
@@ -118,12 +122,7 @@ void ServerAccessControlManager::performAccessControl( VncServerClient* client )
 		break;
 	}
 
-	const auto accessResult =
-			AccessControlProvider().checkAccess( client->username(),
-												 client->hostAddress(),
-												 connectedUsers() );
-
-	switch( accessResult )
+	switch( checkAccess( client ) )
 	{
 	case AccessControlProvider::AccessAllow:
 		client->setAccessControlState( VncServerClient::AccessControlSuccessful );
@@ -142,6 +141,45 @@ void ServerAccessControlManager::performAccessControl( VncServerClient* client )
 
 
 
+AccessControlProvider::AccessResult ServerAccessControlManager::checkAccess( VncServerClient* client )
+{
+	// changes of logged on users or connected users result in different keys
+	const auto localUser = VeyonCore::platform().userInfoFunctions().loggedOnUser();
+
+	auto localUsers = VeyonCore::platform().userInfoFunctions().loggedOnUsers();
+	std::sort( localUsers.begin(), localUsers.end() );
+
+	auto users = connectedUsers().toSet().toList();
+	std::sort( users.begin(), users.end() );
+
+	const auto key = QStringList( { client->username(), client->hostAddress(), localUser,
+									localUsers.join( QLatin1Char(',') ), users.join( QLatin1Char(',') ) } ).
+			join( QLatin1Char('\n') );
+
+	const auto it = m_accessResultCache.constFind( key );
+	if( it != m_accessResultCache.constEnd() && it->timer.elapsed() < AccessResultCacheLifetime )
+	{
+		return it->result;
+	}
+
+	const auto result = AccessControlProvider().checkAccess( client->username(), client->hostAddress(),
+															 localUser, connectedUsers() );
+
+	if( m_accessResultCache.size() >= MaximumCachedAccessResults )
+	{
+		m_accessResultCache.clear();
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+
+	m_accessResultCache[key] = CachedAccessResult { result, timer };
+
+	return result;
+}
+
+
+
 VncServerClient::AccessControlState ServerAccessControlManager::confirmDesktopAccess( VncServerClient* client )
 {
 	const HostUserPair hostUserPair( client->username(), client->hostAddress() );
@@ -25,6 +25,7 @@
 #ifndef SERVER_ACCESS_CONTROL_MANAGER_H
 #define SERVER_ACCESS_CONTROL_MANAGER_H
 
+#include "AccessControlProvider.h"
 #include "DesktopAccessDialog.h"
 #include "RfbVeyonAuth.h"
 #include "VncServerClient.h"
@@ -48,10 +49,19 @@ signals:
 
 private:
 	enum {
-		ClientWaitInterval = 1000
+		ClientWaitInterval = 1000,
+		AccessResultCacheLifetime = 60000,
+		MaximumCachedAccessResults = 1024
 	};
 
+	struct CachedAccessResult
+	{
+		AccessControlProvider::AccessResult result;
+		QElapsedTimer timer;
+	} ;
+
 	void performAccessControl( VncServerClient* client );
+	AccessControlProvider::AccessResult checkAccess( VncServerClient* client );
 	VncServerClient::AccessControlState confirmDesktopAccess( VncServerClient* client );
 	void finishDesktopAccessConfirmation( VncServerClient* client );
 
@@ -67,6 +77,11 @@ private:
 
 	DesktopAccessChoiceMap m_desktopAccessChoices;
 
+	// results of access control rules keyed by accessing user, accessing computer,
+	// local users and connected users - the server is not notified about changed
+	// rules or data backends so cached results only expire after AccessResultCacheLifetime
+	QHash<QString, CachedAccessResult> m_accessResultCache;
+
 } ;
 
 #endif
@@ -22,11 +22,14 @@
  *
  */
 
+#include <QDateTime>
+#include <QFutureWatcher>
 #include <QHostAddress>
+#include <QMessageAuthenticationCode>
+#include <QtConcurrent>
 
 #include "ServerAuthenticationManager.h"
 #include "AuthenticationCredentials.h"
-#include "CryptoCore.h"
 #include "VeyonConfiguration.h"
 #include "LocalSystem.h"
 #include "LogonAuthentication.h"
@@ -36,10 +39,22 @@
 ServerAuthenticationManager::ServerAuthenticationManager( QObject* parent ) :
 	QObject( parent ),
 	m_allowedIPs(),
-	m_failedAuthHosts()
+	m_failedAuthHosts(),
+	m_rsaKeyPool(),
+	m_publicKeys(),
+	m_publicKeyWatcher( this ),
+	m_verificationThreadPool( this ),
+	m_resumptionTickets()
 {
+	if( VeyonCore::config().isLogonAuthenticationEnabled() )
+	{
+		m_rsaKeyPool.fill();
+	}
 
+	m_verificationThreadPool.setMaxThreadCount( VerificationThreadCount );
 
+	connect( &m_publicKeyWatcher, &QFileSystemWatcher::fileChanged,
+			 this, &ServerAuthenticationManager::invalidatePublicKey );
 }
 
 
@@ -65,6 +80,11 @@ QVector<RfbVeyonAuth::Type> ServerAuthenticationManager::supportedAuthTypes() co
 		authTypes.append( RfbVeyonAuth::Token );
 	}
 
+	if( VeyonCore::config().isKeyAuthenticationEnabled() || VeyonCore::config().isLogonAuthenticationEnabled() )
+	{
+		authTypes.append( RfbVeyonAuth::Ticket );
+	}
+
 	return authTypes;
 }
 
@@ -104,6 +124,10 @@ void ServerAuthenticationManager::processAuthenticationMessage( VncServerClient*
 		client->setAuthState( performTokenAuthentication( client, message ) );
 		break;
 
+	case RfbVeyonAuth::Ticket:
+		client->setAuthState( performTicketAuthentication( client, message ) );
+		break;
+
 	default:
 		break;
 	}
@@ -124,6 +148,54 @@ void ServerAuthenticationManager::setAllowedIPs(const QStringList &allowedIPs)
 
 
 
+QString ServerAuthenticationManager::publicKeyPEM( VeyonCore::UserRoles role )
+{
+	if( m_publicKeys.contains( role ) )
+	{
+		return m_publicKeys[role];
+	}
+
+	// (publicKeyPath does range-checking of role)
+	const auto path = LocalSystem::Path::publicKeyPath( role );
+
+	qDebug() << "Loading public key" << path << "for role" << role;
+
+	const CryptoCore::PublicKey key( path );
+	if( key.isNull() )
+	{
+		return QString();
+	}
+
+	// only cache PEM data as QCA objects are bound to the thread they were created in
+	const auto pem = key.toPEM();
+	m_publicKeys[role] = pem;
+	m_publicKeyWatcher.addPath( path );
+
+	return pem;
+}
+
+
+
+void ServerAuthenticationManager::invalidatePublicKey( const QString& path )
+{
+	for( auto it = m_publicKeys.begin(); it != m_publicKeys.end(); )
+	{
+		if( LocalSystem::Path::publicKeyPath( static_cast<VeyonCore::UserRoles>( it.key() ) ) == path )
+		{
+			it = m_publicKeys.erase( it );
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	// files replaced by new ones are not watched any longer
+	m_publicKeyWatcher.removePath( path );
+}
+
+
+
 VncServerClient::AuthState ServerAuthenticationManager::performKeyAuthentication( VncServerClient* client,
 																				  VariantArrayMessage& message )
 {
@@ -150,22 +222,51 @@ VncServerClient::AuthState ServerAuthenticationManager::performKeyAuthentication
 		// now try to verify received signed data using public key of the user
 		// under which the client claims to run
 		const QByteArray signature = message.read().toByteArray();
+		const QByteArray challenge = client->challenge();
 
-		qDebug() << "Loading public key" << LocalSystem::Path::publicKeyPath( urole ) << "for role" << urole;
-		// (publicKeyPath does range-checking of urole)
-		CryptoCore::PublicKey publicKey( LocalSystem::Path::publicKeyPath( urole ) );
-
-		if( publicKey.verifyMessage( client->challenge(), signature, CryptoCore::DefaultSignatureAlgorithm ) )
+		const auto keyPEM = publicKeyPEM( urole );
+		if( keyPEM.isEmpty() )
 		{
-			qDebug( "ServerAuthenticationManager::performKeyAuthentication(): SUCCESS" );
-			return VncServerClient::AuthFinishedSuccess;
-		}
-		else
-		{
-			qDebug( "ServerAuthenticationManager::performKeyAuthentication(): FAIL" );
+			qWarning() << "ServerAuthenticationManager::performKeyAuthentication(): no public key for role" << urole;
 			return VncServerClient::AuthFinishedFail;
 		}
-		break;
+
+		// verify signature in background so other connections are not stalled - the key
+		// is passed as PEM and constructed inside the worker thread
+		auto watcher = new QFutureWatcher<bool>( client );
+
+		const auto ioDevice = message.ioDevice();
+
+		connect( watcher, &QFutureWatcher<bool>::finished, client, [=]() {
+			if( watcher->result() )
+			{
+				qDebug( "ServerAuthenticationManager::performKeyAuthentication(): SUCCESS" );
+				if( client->resumptionTicketRequested() )
+				{
+					// only the owner of the private key is able to decrypt the ticket secret
+					const auto secret = CryptoCore::generateChallenge().left( ResumptionTicketSecretSize );
+					auto encryptionKey = CryptoCore::PublicKey::fromPEM( keyPEM );
+					const auto encryptedSecret = encryptionKey.encrypt( secret, CryptoCore::DefaultEncryptionAlgorithm ).toByteArray();
+					sendResumptionTicket( client, ioDevice, encryptedSecret.isEmpty() ? QByteArray() : secret, encryptedSecret );
+				}
+				client->finishAuthentication( VncServerClient::AuthFinishedSuccess );
+			}
+			else
+			{
+				qDebug( "ServerAuthenticationManager::performKeyAuthentication(): FAIL" );
+				client->finishAuthentication( VncServerClient::AuthFinishedFail );
+				emit authenticationError( client->hostAddress(), client->username() );
+			}
+			watcher->deleteLater();
+		} );
+
+		watcher->setFuture( QtConcurrent::run( &m_verificationThreadPool, [=]() {
+			auto verificationKey = CryptoCore::PublicKey::fromPEM( keyPEM );
+			return verificationKey.isNull() == false &&
+					verificationKey.verifyMessage( challenge, signature, CryptoCore::DefaultSignatureAlgorithm );
+		} ) );
+
+		return VncServerClient::AuthPending;
 	}
 
 	default:
@@ -184,13 +285,12 @@ VncServerClient::AuthState ServerAuthenticationManager::performLogonAuthenticati
 	{
 	case VncServerClient::AuthInit:
 	{
-		CryptoCore::PrivateKey privateKey = CryptoCore::KeyGenerator().createRSA( CryptoCore::RsaKeySize );
-
-		client->setPrivateKey( privateKey.toPEM() );
+		// use pre-generated key pair as generating it takes quite a while
+		const auto keyPair = m_rsaKeyPool.takeKeyPair();
 
-		CryptoCore::PublicKey publicKey = privateKey.toPublicKey();
+		client->setPrivateKey( keyPair.privateKey );
 
-		if( VariantArrayMessage( message.ioDevice() ).write( publicKey.toPEM() ).send() )
+		if( VariantArrayMessage( message.ioDevice() ).write( keyPair.publicKey ).send() )
 		{
 			return VncServerClient::AuthPassword;
 		}
@@ -217,6 +317,17 @@ VncServerClient::AuthState ServerAuthenticationManager::performLogonAuthenticati
 			return VncServerClient::AuthFinishedFail;
 		}
 
+		// clients requesting a resumption ticket choose the ticket secret and send it encrypted the same way
+		CryptoCore::SecureArray ticketSecret;
+		if( client->resumptionTicketRequested() &&
+				privateKey.decrypt( CryptoCore::SecureArray( message.read().toByteArray() ),
+									&ticketSecret,
+									CryptoCore::DefaultEncryptionAlgorithm ) == false )
+		{
+			qWarning( "ServerAuthenticationManager::performLogonAuthentication(): failed to decrypt ticket secret" );
+			ticketSecret.clear();
+		}
+
 		AuthenticationCredentials credentials;
 		credentials.setLogonUsername( client->username() );
 		credentials.setLogonPassword( QString::fromUtf8( decryptedPassword.toByteArray() ) );
@@ -224,6 +335,10 @@ VncServerClient::AuthState ServerAuthenticationManager::performLogonAuthenticati
 		if( LogonAuthentication::authenticateUser( credentials ) )
 		{
 			qDebug( "ServerAuthenticationManager::performLogonAuthentication(): SUCCESS" );
+			if( client->resumptionTicketRequested() )
+			{
+				sendResumptionTicket( client, message.ioDevice(), ticketSecret.toByteArray(), QByteArray() );
+			}
 			return VncServerClient::AuthFinishedSuccess;
 		}
 
@@ -289,3 +404,123 @@ VncServerClient::AuthState ServerAuthenticationManager::performTokenAuthenticati
 
 	return VncServerClient::AuthFinishedFail;
 }
+
+
+
+VncServerClient::AuthState ServerAuthenticationManager::performTicketAuthentication( VncServerClient* client,
+																					 VariantArrayMessage& message )
+{
+	switch( client->authState() )
+	{
+	case VncServerClient::AuthInit:
+		client->setChallenge( CryptoCore::generateChallenge() );
+		if( VariantArrayMessage( message.ioDevice() ).write( client->challenge() ).send() )
+		{
+			return VncServerClient::AuthTicket;
+		}
+
+		qDebug( "ServerAuthenticationManager::performTicketAuthentication(): failed to send challenge" );
+		return VncServerClient::AuthFinishedFail;
+
+	case VncServerClient::AuthTicket:
+	{
+		const auto ticketId = message.read().toByteArray();
+		const auto response = message.read().toByteArray();
+
+		if( verifyResumptionTicket( client, ticketId, response ) )
+		{
+			qDebug( "ServerAuthenticationManager::performTicketAuthentication(): SUCCESS" );
+			return VncServerClient::AuthFinishedSuccess;
+		}
+
+		qDebug( "ServerAuthenticationManager::performTicketAuthentication(): FAIL" );
+		return VncServerClient::AuthFinishedFail;
+	}
+
+	default:
+		break;
+	}
+
+	return VncServerClient::AuthFinishedFail;
+}
+
+
+
+void ServerAuthenticationManager::sendResumptionTicket( VncServerClient* client, QIODevice* ioDevice,
+														const QByteArray& secret, const QByteArray& encryptedSecret )
+{
+	removeExpiredResumptionTickets();
+
+	// the client waits for a ticket in any case so send an empty one if no secret could be exchanged
+	QByteArray ticketId;
+
+	if( secret.isEmpty() == false )
+	{
+		ticketId = CryptoCore::generateChallenge();
+		m_resumptionTickets[ticketId] = { client->username(),
+										  client->hostAddress(),
+										  QDateTime::currentMSecsSinceEpoch() + ResumptionTicketLifetime * 1000,
+										  secret };
+	}
+
+	// sent before the authentication result so the client can read it within its authentication handler
+	VariantArrayMessage( ioDevice ).write( ticketId ).write( ResumptionTicketLifetime ).write( encryptedSecret ).send();
+}
+
+
+
+bool ServerAuthenticationManager::verifyResumptionTicket( VncServerClient* client,
+														  const QByteArray& ticketId, const QByteArray& response )
+{
+	removeExpiredResumptionTickets();
+
+	// tickets can only be used once so recorded handshakes can't be replayed
+	const auto ticket = m_resumptionTickets.take( ticketId );
+	if( ticket.secret.isEmpty() )
+	{
+		qWarning( "ServerAuthenticationManager: unknown or expired resumption ticket" );
+		return false;
+	}
+
+	// tickets must not be passed to other users or hosts
+	if( ticket.username != client->username() || ticket.hostAddress != client->hostAddress() )
+	{
+		return false;
+	}
+
+	// the ticket itself is sent in clear text so the client has to prove it knows the ticket secret
+	const auto expectedResponse = QMessageAuthenticationCode::hash( client->challenge(), ticket.secret,
+																	QCryptographicHash::Sha256 );
+	if( response.size() != expectedResponse.size() )
+	{
+		return false;
+	}
+
+	// compare in constant time
+	char difference = 0;
+	for( int i = 0; i < expectedResponse.size(); ++i )
+	{
+		difference |= response[i] ^ expectedResponse[i];
+	}
+
+	return difference == 0;
+}
+
+
+
+void ServerAuthenticationManager::removeExpiredResumptionTickets()
+{
+	const auto now = QDateTime::currentMSecsSinceEpoch();
+
+	for( auto it = m_resumptionTickets.begin(); it != m_resumptionTickets.end(); )
+	{
+		if( it->expiryTime <= now )
+		{
+			it = m_resumptionTickets.erase( it );
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
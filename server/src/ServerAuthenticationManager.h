@@ -25,10 +25,14 @@
 #ifndef SERVER_AUTHENTICATION_MANAGER_H
 #define SERVER_AUTHENTICATION_MANAGER_H
 
+#include <QFileSystemWatcher>
 #include <QMutex>
 #include <QStringList>
+#include <QThreadPool>
 
+#include "CryptoCore.h"
 #include "RfbVeyonAuth.h"
+#include "RsaKeyPool.h"
 #include "VncServerClient.h"
 
 class VariantArrayMessage;
@@ -37,6 +41,10 @@ class ServerAuthenticationManager : public QObject
 {
 	Q_OBJECT
 public:
+	enum {
+		ResumptionTicketLifetime = 300		/**< in seconds */
+	};
+
 	ServerAuthenticationManager( QObject* parent );
 
 	QVector<RfbVeyonAuth::Type> supportedAuthTypes() const;
@@ -51,16 +59,49 @@ signals:
 	void authenticationError( const QString& host, const QString& user );
 
 private:
+	enum {
+		VerificationThreadCount = 2,
+		ResumptionTicketSecretSize = 32		/**< small enough for RSA encryption with any key size in use */
+	};
+
+	struct ResumptionTicket
+	{
+		QString username;
+		QString hostAddress;
+		qint64 expiryTime;
+		QByteArray secret;
+	} ;
+
+	QString publicKeyPEM( VeyonCore::UserRoles role );
+	void invalidatePublicKey( const QString& path );
+
 	VncServerClient::AuthState performKeyAuthentication( VncServerClient* client, VariantArrayMessage& message );
 	VncServerClient::AuthState performLogonAuthentication( VncServerClient* client, VariantArrayMessage& message );
 	VncServerClient::AuthState performHostWhitelistAuth( VncServerClient* client, VariantArrayMessage& message );
 	VncServerClient::AuthState performTokenAuthentication( VncServerClient* client, VariantArrayMessage& message );
+	VncServerClient::AuthState performTicketAuthentication( VncServerClient* client, VariantArrayMessage& message );
+
+	void sendResumptionTicket( VncServerClient* client, QIODevice* ioDevice,
+							   const QByteArray& secret, const QByteArray& encryptedSecret );
+	bool verifyResumptionTicket( VncServerClient* client, const QByteArray& ticketId, const QByteArray& response );
+	void removeExpiredResumptionTickets();
 
 	QMutex m_dataMutex;
 	QStringList m_allowedIPs;
 
 	QStringList m_failedAuthHosts;
 
+	RsaKeyPool m_rsaKeyPool;
+
+	// parsed public keys per role, dropped as soon as the key file changes
+	QHash<int, QString> m_publicKeys;
+	QFileSystemWatcher m_publicKeyWatcher;
+
+	QThreadPool m_verificationThreadPool;
+
+	// issued resumption tickets by ticket ID - tickets become invalid when the server restarts
+	QHash<QByteArray, ResumptionTicket> m_resumptionTickets;
+
 } ;
 
 #endif
@@ -113,6 +113,10 @@ void VncProxyConnection::readFromServer()
 			// we can forward to the real client
 			serverProtocol().setServerInitMessage( clientProtocol().serverInitMessage() );
 
+			// framebuffer updates make up most of the traffic so do not copy them around
+			// but let client protocol write them to the client socket right away
+			clientProtocol().setFramebufferUpdateForwardingDevice( m_proxyClientSocket );
+
 			readFromServerLater();
 		}
 	}
@@ -212,7 +216,10 @@ bool VncProxyConnection::receiveServerMessage()
 {
 	if( clientProtocol().receiveMessage() )
 	{
-		m_proxyClientSocket->write( clientProtocol().lastMessage() );
+		if( clientProtocol().isLastMessageForwarded() == false )
+		{
+			m_proxyClientSocket->write( clientProtocol().lastMessage() );
+		}
 
 		return true;
 	}